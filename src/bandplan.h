@@ -0,0 +1,84 @@
+/*
+	Band plan: the sub-bands of every band, looked up by entry index in main.c.
+
+	The entries of a band are consecutive, FM first, then MW, then SW, in the order of the
+	band numbers in main.c. Entry 'i' belongs to band 'b' when bandplan_first[b] <= i < bandplan_first[b + 1],
+	and the first entry of a band is its default.
+
+	Frequencies and steps are in the Si4735's units: 10kHz in FM, 1kHz in AM.
+	'filter' is the SI4735_FM_DEEMPHASIS value of FM entries and the SI4735_AM_CHANNEL_FILTER value of AM ones.
+	'name' is shown on the main screen, up to 4 characters.
+*/
+
+#ifndef __BANDPLAN__
+#define __BANDPLAN__
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "si4735_properties.h"
+
+
+
+
+struct bandplan
+{
+  char name[5];
+  uint16_t bottom;
+  uint16_t top;
+  uint8_t step;
+  uint8_t filter;
+};
+
+
+
+
+/*
+	First entry of every band.
+*/
+
+#define BANDPLAN_FM 0
+#define BANDPLAN_MW 4
+#define BANDPLAN_SW 7
+#define BANDPLAN_ENTRIES 22
+
+const uint8_t bandplan_first[] PROGMEM = { BANDPLAN_FM, BANDPLAN_MW, BANDPLAN_SW, BANDPLAN_ENTRIES };
+
+
+
+
+/*
+	Entries
+*/
+
+const struct bandplan bandplan[BANDPLAN_ENTRIES] PROGMEM = {
+
+	// FM: Europe, Americas, Japan, OIRT.
+	{ "EU",   8750, 10800,  5, SI4735_EUR_50us },
+	{ "US",   8790, 10790, 20, SI4735_USA_75us },
+	{ "JP",   7600,  9500, 10, SI4735_EUR_50us },
+	{ "OIRT", 6580,  7400,  3, SI4735_EUR_50us },
+
+	// MW: 9kHz raster (Europe, Africa, Asia), 10kHz raster (Americas), LW.
+	{ "MW",    522,  1620,  9, SI4735_BW4KHZ },
+	{ "MW10",  520,  1710, 10, SI4735_BW4KHZ },
+	{ "LW",    153,   279,  9, SI4735_BW4KHZ },
+
+	// SW: the whole range, then the broadcast meter bands.
+	{ "SW",   2300, 26100,  5, SI4735_BW4KHZ },
+	{ "120m", 2300,  2495,  5, SI4735_BW4KHZ },
+	{ "90m",  3200,  3400,  5, SI4735_BW4KHZ },
+	{ "75m",  3900,  4000,  5, SI4735_BW4KHZ },
+	{ "60m",  4750,  5060,  5, SI4735_BW4KHZ },
+	{ "49m",  5900,  6200,  5, SI4735_BW4KHZ },
+	{ "41m",  7200,  7450,  5, SI4735_BW4KHZ },
+	{ "31m",  9400,  9900,  5, SI4735_BW4KHZ },
+	{ "25m", 11600, 12100,  5, SI4735_BW4KHZ },
+	{ "22m", 13570, 13870,  5, SI4735_BW4KHZ },
+	{ "19m", 15100, 15800,  5, SI4735_BW4KHZ },
+	{ "16m", 17480, 17900,  5, SI4735_BW4KHZ },
+	{ "15m", 18900, 19020,  5, SI4735_BW4KHZ },
+	{ "13m", 21450, 21850,  5, SI4735_BW4KHZ },
+	{ "11m", 25670, 26100,  5, SI4735_BW4KHZ },
+};
+
+#endif
@@ -0,0 +1,122 @@
+/*
+    CAT: a compact binary remote control protocol over the UART.
+*/
+
+#include "cat.h"
+#include "uart.h"
+
+
+
+
+/*
+    Globals
+*/
+
+uint8_t cat_errors, cat_drops;
+
+// parser state: the next byte expected, the frame so far, its check and the polls since its last byte.
+#define CAT_WAIT_SYNC 0
+#define CAT_WAIT_COMMAND 1
+#define CAT_WAIT_LENGTH 2
+#define CAT_WAIT_DATA 3
+#define CAT_WAIT_CHECK 4
+uint8_t cat_state, cat_count, cat_check, cat_wait;
+struct cat_frame cat_frame;
+
+// polls left before the parser may be idle after a wake up.
+uint8_t cat_wake_wait;
+
+
+
+
+/*
+    Poll
+*/
+
+uint8_t cat_poll(struct cat_frame *frame)
+{
+  uint8_t byte, received = 0, i;
+
+  while(uart_read(&byte))
+  {
+    received = 1;
+    cat_wait = 0;
+    switch(cat_state)
+    {
+      case CAT_WAIT_SYNC :
+        if(byte == CAT_SYNC) cat_state = CAT_WAIT_COMMAND;
+        break;
+
+      case CAT_WAIT_COMMAND :
+        cat_frame.command = byte;
+        cat_check = byte;
+        cat_state = CAT_WAIT_LENGTH;
+        break;
+
+      case CAT_WAIT_LENGTH :
+        if(byte > CAT_DATA_MAX) { cat_state = CAT_WAIT_SYNC; cat_errors++; break; }
+        cat_frame.length = byte;
+        cat_check ^= byte;
+        cat_count = 0;
+        cat_state = byte ? CAT_WAIT_DATA : CAT_WAIT_CHECK;
+        break;
+
+      case CAT_WAIT_DATA :
+        cat_frame.data[cat_count++] = byte;
+        cat_check ^= byte;
+        if(cat_count == cat_frame.length) cat_state = CAT_WAIT_CHECK;
+        break;
+
+      case CAT_WAIT_CHECK :
+        cat_state = CAT_WAIT_SYNC;
+        if(byte != cat_check) { cat_errors++; break; }
+        frame->command = cat_frame.command;
+        frame->length = cat_frame.length;
+        for(i = 0; i < cat_frame.length; i++) frame->data[i] = cat_frame.data[i];
+        return 1;
+    }
+  }
+
+  if(cat_wake_wait) cat_wake_wait--;
+  if(!received && cat_state != CAT_WAIT_SYNC && ++cat_wait > CAT_FRAME_TIMEOUT) { cat_state = CAT_WAIT_SYNC; cat_errors++; }
+  return 0;
+}
+
+
+
+
+/*
+    Send
+*/
+
+uint8_t cat_send(uint8_t command, const uint8_t *data, uint8_t length)
+{
+  uint8_t frame[CAT_DATA_MAX + 4], check = command ^ length, i;
+
+  frame[0] = CAT_SYNC;
+  frame[1] = command;
+  frame[2] = length;
+  for(i = 0; i < length; i++) { frame[3 + i] = data[i]; check ^= data[i]; }
+  frame[3 + length] = check;
+
+  if(uart_write(frame, length + 4)) return 1;
+  if(cat_drops != 255) cat_drops++;
+  return 0;
+}
+
+
+
+
+/*
+    Idle
+*/
+
+uint8_t cat_idle(void)
+{
+  return cat_state == CAT_WAIT_SYNC && !cat_wake_wait;
+}
+
+void cat_wake(void)
+{
+  cat_wake_wait = CAT_WAKE_TIMEOUT;
+}
@@ -0,0 +1,167 @@
+/*
+    CAT: a compact binary remote control protocol over the UART.
+
+    Every message is a frame:
+
+      CAT_SYNC, command, length, data[length], check
+
+    'length' is at most CAT_DATA_MAX and 'check' is the XOR of the command, the length and the data bytes.
+    Multi-byte values are little endian.
+
+    The host sends commands. Every command gets one reply, with the command code or'ed with CAT_REPLY
+    and a status (CAT_OK or an error) as its first data byte, followed by the command's results.
+    The receiver also sends events on its own, once enabled with CAT_STREAM.
+
+    Frames are parsed a byte at a time from the UART's receive buffer, so parsing never waits for the line.
+    A frame with a bad length or check is dropped (counted in 'cat_errors'), as is a frame left unfinished
+    for CAT_FRAME_TIMEOUT polls, and the parser looks for the next CAT_SYNC.
+    A reply or event not fitting in the UART's transmit buffer is dropped whole, counted in 'cat_drops'.
+
+    With the radio off the MCU sleeps in power down, where the UART receives nothing. A byte arriving
+    wakes it up, but is lost. To wake it, the host sends CAT_WAKE_BYTE, waits CAT_WAKE_DELAY_MS, then sends
+    its frame. After any wake up 'cat_wake()' keeps the parser from being idle for CAT_WAKE_TIMEOUT polls,
+    so that the MCU stays awake until the frame has started.
+
+    This header depends on nothing but stdint.h, so that host programs can include it for the protocol's definitions.
+    The commands are executed in main.c.
+*/
+
+#ifndef __CAT__
+#define __CAT__
+
+#include <stdint.h>
+
+
+
+
+/*
+    Framing
+*/
+
+#define CAT_SYNC 0xa5
+#define CAT_DATA_MAX 15
+#define CAT_REPLY 0x80
+
+// Polls of 'cat_poll()' (scheduler ticks) a frame may take to arrive.
+#define CAT_FRAME_TIMEOUT 4
+
+// Waking the MCU up: a byte with a single falling edge, so that no part of it is taken for a start bit,
+// the host's wait before the frame, and the polls the MCU stays awake for (65ms, well over the wait).
+#define CAT_WAKE_BYTE 0x00
+#define CAT_WAKE_DELAY_MS 10
+#define CAT_WAKE_TIMEOUT 8
+
+
+
+
+/*
+    Commands, their data and their replies' data after the status.
+*/
+
+#define CAT_PING 0x00          // any data; reply: the same data.
+#define CAT_TUNE 0x01          // freq (u16, the band's units); reply: freq (u16).
+#define CAT_SEEK 0x02          // direction (s8, 1 up, -1 down); reply: none, the station found comes as a CAT_TUNED event.
+#define CAT_BAND 0x03          // band (u8, CAT_BAND_x); reply: none.
+#define CAT_SET_PROPERTY 0x04  // property (u16), value (u16); reply: none.
+#define CAT_GET_PROPERTY 0x05  // property (u16); reply: value (u16).
+#define CAT_RSQ 0x06           // none; reply: rssi (u8), snr (u8), freq offset (s8), stereo blend (u8), flags (u8, CAT_RSQ_x).
+#define CAT_STREAM 0x07        // events to send (u8, CAT_STREAM_x); reply: none.
+#define CAT_TELEMETRY_RATE 0x08 // sample rate (u16, Hz, 0 stops); reply: sample period (u16, uS), time unit (u8, uS).
+
+#define CAT_BAND_FM 0
+#define CAT_BAND_MW 1
+#define CAT_BAND_SW 2
+#define CAT_BAND_OFF 3
+
+#define CAT_RSQ_VALID 0x01
+#define CAT_RSQ_STEREO 0x02
+
+#define CAT_STREAM_TUNED 0x01
+#define CAT_STREAM_RDS 0x02
+
+
+
+
+/*
+    Reply status
+*/
+
+#define CAT_OK 0
+#define CAT_ERR_COMMAND 1      // unknown command.
+#define CAT_ERR_LENGTH 2       // wrong data length for the command.
+#define CAT_ERR_VALUE 3        // value out of range.
+#define CAT_ERR_OFF 4          // the radio is off (or starting).
+
+
+
+
+/*
+    Events
+*/
+
+#define CAT_TUNED 0x40         // a channel was tuned; band (u8), freq (u16), valid (u8).
+#define CAT_RDS 0x41           // an RDS group; block A - D (u16 each), block errors (u8, SI4735_BLEA - BLED, 2 bits each from the msb).
+#define CAT_TELEMETRY 0x42     // RSQ samples; sequence number (u8) and time (u16, in the time unit) of the first sample,
+                               // then 1 - 3 consecutive samples of rssi (u8), snr (u8), multipath (u8), freq offset (s8).
+
+
+
+
+/*
+    Globals
+*/
+
+struct cat_frame
+{
+  uint8_t command;
+  uint8_t length;
+  uint8_t data[CAT_DATA_MAX];
+};
+
+extern uint8_t cat_errors, cat_drops;
+
+
+
+
+/*
+    API
+*/
+
+/*
+    Take the next complete command frame received into 'frame'. Returns 0 when there is none (yet).
+    To be called periodically, every scheduler tick.
+*/
+
+uint8_t cat_poll(struct cat_frame *frame);
+
+
+
+
+/*
+    Send a frame. Returns 0 when it was dropped.
+*/
+
+uint8_t cat_send(uint8_t command, const uint8_t *data, uint8_t length);
+
+
+
+
+/*
+    Returns non zero when no frame is being received, and no frame is expected after a wake up.
+*/
+
+uint8_t cat_idle(void);
+
+
+
+
+/*
+    Expect a frame after a wake up: 'cat_idle()' stays 0 for the next CAT_WAKE_TIMEOUT polls.
+*/
+
+void cat_wake(void);
+
+
+
+
+#endif
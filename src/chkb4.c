@@ -1,39 +1,50 @@
 #include "chkb4.h"
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 
 
 
 
 /*
-	keyboard I/O control macros
+	keyboard line table
 */
 
-// line 0
-#define chkb4_line_0_set_out() CHKB4_LINE_0_PDIR |= 1 << CHKB4_LINE_0_BIT
-#define chkb4_line_0_set_in() CHKB4_LINE_0_PDIR &= ~( 1 << CHKB4_LINE_0_BIT )
-#define chkb4_line_0_set_hi() CHKB4_LINE_0_PORT |= 1 << CHKB4_LINE_0_BIT
-#define chkb4_line_0_set_low() CHKB4_LINE_0_PORT &= ~( 1 << CHKB4_LINE_0_BIT )
-#define chkb4_line_0_read() ( ( ~CHKB4_LINE_0_PIN & ( 1 << CHKB4_LINE_0_BIT ) ) >> CHKB4_LINE_0_BIT )
+#ifdef CHKB4_SHARED_PORT
 
-// line 1
-#define chkb4_line_1_set_out() CHKB4_LINE_1_PDIR |= 1 << CHKB4_LINE_1_BIT
-#define chkb4_line_1_set_in() CHKB4_LINE_1_PDIR &= ~( 1 << CHKB4_LINE_1_BIT )
-#define chkb4_line_1_set_hi() CHKB4_LINE_1_PORT |= 1 << CHKB4_LINE_1_BIT
-#define chkb4_line_1_set_low() CHKB4_LINE_1_PORT &= ~( 1 << CHKB4_LINE_1_BIT )
-#define chkb4_line_1_read() ( ( ~CHKB4_LINE_1_PIN & ( 1 << CHKB4_LINE_1_BIT ) ) >> CHKB4_LINE_1_BIT )
+// all the lines on line 0's port, at consecutive bits
+#define CHKB4_PORT CHKB4_LINE_0_PORT
+#define CHKB4_PDIR CHKB4_LINE_0_PDIR
+#define CHKB4_PIN CHKB4_LINE_0_PIN
+#define CHKB4_PCMSK CHKB4_LINE_0_PCMSK
+#define CHKB4_PCIE CHKB4_LINE_0_PCIE
+#define CHKB4_LINES_MASK ( ( ( 1 << CHKB4_LINES ) - 1 ) << CHKB4_LINE_0_BIT )
 
-// line 2
-#define chkb4_line_2_set_out() CHKB4_LINE_2_PDIR |= 1 << CHKB4_LINE_2_BIT
-#define chkb4_line_2_set_in() CHKB4_LINE_2_PDIR &= ~( 1 << CHKB4_LINE_2_BIT )
-#define chkb4_line_2_set_hi() CHKB4_LINE_2_PORT |= 1 << CHKB4_LINE_2_BIT
-#define chkb4_line_2_set_low() CHKB4_LINE_2_PORT &= ~( 1 << CHKB4_LINE_2_BIT )
-#define chkb4_line_2_read() ( ( ~CHKB4_LINE_2_PIN & ( 1 << CHKB4_LINE_2_BIT ) ) >> CHKB4_LINE_2_BIT )
+#else
 
-// line 3
-#define chkb4_line_3_set_out() CHKB4_LINE_3_PDIR |= 1 << CHKB4_LINE_3_BIT
-#define chkb4_line_3_set_in() CHKB4_LINE_3_PDIR &= ~( 1 << CHKB4_LINE_3_BIT )
-#define chkb4_line_3_set_hi() CHKB4_LINE_3_PORT |= 1 << CHKB4_LINE_3_BIT
-#define chkb4_line_3_set_low() CHKB4_LINE_3_PORT &= ~( 1 << CHKB4_LINE_3_BIT )
-#define chkb4_line_3_read() ( ( ~CHKB4_LINE_3_PIN & ( 1 << CHKB4_LINE_3_BIT ) ) >> CHKB4_LINE_3_BIT )
+struct chkb4_line
+{
+	volatile uint8_t *port;
+	volatile uint8_t *pdir;
+	volatile uint8_t *pin;
+	uint8_t mask;
+	volatile uint8_t *pcmsk;
+	uint8_t pcie;
+};
+
+#define CHKB4_LINE( n ) { &CHKB4_LINE_##n##_PORT, &CHKB4_LINE_##n##_PDIR, &CHKB4_LINE_##n##_PIN, \
+			1 << CHKB4_LINE_##n##_BIT, &CHKB4_LINE_##n##_PCMSK, CHKB4_LINE_##n##_PCIE }
+
+const struct chkb4_line chkb4_line_table[CHKB4_LINES] = {
+	CHKB4_LINE( 0 ),
+	CHKB4_LINE( 1 ),
+	CHKB4_LINE( 2 ),
+	CHKB4_LINE( 3 ),
+#if CHKB4_LINES > 4
+	CHKB4_LINE( 4 ),
+#endif
+};
+
+#endif
 
 
 
@@ -42,7 +53,24 @@
 	Globals
 */
 
-uint16_t keys_old_sample, keys_current_sample, key_flags;
+chkb4_keys_t keys_sample, keys_state;
+
+// debounce vertical counter, bit 0 and bit 1 of every key's counter.
+chkb4_keys_t keys_count_0, keys_count_1;
+
+volatile uint16_t chkb4_time;
+
+// the key being followed for long press and auto-repeat, its hold time and the runs left to the next repeat.
+#define CHKB4_NO_KEY 0xff
+uint8_t chkb4_held_key = CHKB4_NO_KEY, chkb4_hold_time, chkb4_repeat_wait;
+volatile uint8_t chkb4_overflows;
+
+// key event queue, written at the head by chkb4_update() and read at the tail by chkb4_get_event().
+volatile struct chkb4_event chkb4_queue[CHKB4_QUEUE_SIZE];
+volatile uint8_t chkb4_queue_head, chkb4_queue_tail;
+
+// runs of chkb4_update() left before the keyboard may be idle again after a wake up.
+volatile uint8_t chkb4_wake_wait;
 
 
 
@@ -54,115 +82,205 @@ uint16_t keys_old_sample, keys_current_sample, key_flags;
 void chkb4_init( void )
 {
 	// set all lines to input with pull-ups
-	chkb4_line_0_set_in();
-	chkb4_line_0_set_hi();
-	chkb4_line_1_set_in();
-	chkb4_line_1_set_hi();
-	chkb4_line_2_set_in();
-	chkb4_line_2_set_hi();
-	chkb4_line_3_set_in();
-	chkb4_line_3_set_hi();
+#ifdef CHKB4_SHARED_PORT
+	CHKB4_PDIR &= ~CHKB4_LINES_MASK;
+	CHKB4_PORT |= CHKB4_LINES_MASK;
+#else
+	uint8_t line;
+	for( line = 0; line < CHKB4_LINES; line++ )
+	{
+		*chkb4_line_table[line].pdir &= ~chkb4_line_table[line].mask;
+		*chkb4_line_table[line].port |= chkb4_line_table[line].mask;
+	}
+#endif
 }
 
 
 
 
 /*
-	keyborad update
+	keyboard scan
+
+	Returns the keys found pressed.
 */
 
-void chkb4_update( void )
+#ifdef CHKB4_SHARED_PORT
+
+chkb4_keys_t chkb4_scan( void )
 {
-	// preserve the current sample
-	keys_old_sample = keys_current_sample;
-
-	// set LINE 0 as collumn driver
-	chkb4_line_0_set_out();
-	chkb4_line_0_set_low();
-	// read lines 1-3
-	keys_current_sample &= ~( 1 << KEY_00 );
-	keys_current_sample |= chkb4_line_1_read() << KEY_00;
-	keys_current_sample &= ~( 1 << KEY_01 );
-	keys_current_sample |= chkb4_line_2_read() << KEY_01;
-	keys_current_sample &= ~( 1 << KEY_02 );
-	keys_current_sample |= chkb4_line_3_read() << KEY_02;
-	// set line 0 as input with pull-up
-	chkb4_line_0_set_hi();
-	chkb4_line_0_set_in();
-
-
-	// set LINE 1 as collumn driver
-	chkb4_line_1_set_out();
-	chkb4_line_1_set_low();
-	// read lines 0,2,3
-	keys_current_sample &= ~( 1 << KEY_03 );
-	keys_current_sample |= chkb4_line_0_read() << KEY_03;
-	keys_current_sample &= ~( 1 << KEY_04 );
-	keys_current_sample |= chkb4_line_2_read() << KEY_04;
-	keys_current_sample &= ~( 1 << KEY_05 );
-	keys_current_sample |= chkb4_line_3_read() << KEY_05;
-	// set line 1 as input with pull-up
-	chkb4_line_1_set_hi();
-	chkb4_line_1_set_in();
-	
-
-	// set LINE 2 as collumn driver
-	chkb4_line_2_set_out();
-	chkb4_line_2_set_low();
-	// read lines 0,1,3
-	keys_current_sample &= ~( 1 << KEY_06 );
-	keys_current_sample |= chkb4_line_0_read() << KEY_06;
-	keys_current_sample &= ~( 1 << KEY_07 );
-	keys_current_sample |= chkb4_line_1_read() << KEY_07;
-	keys_current_sample &= ~( 1 << KEY_08 );
-	keys_current_sample |= chkb4_line_3_read() << KEY_08;
-	// set line 2 as input with pull-up
-	chkb4_line_2_set_hi();
-	chkb4_line_2_set_in();
-	
-
-	// set LINE 3 as collumn driver
-	chkb4_line_3_set_out();
-	chkb4_line_3_set_low();
-	// read lines 0-2
-	keys_current_sample &= ~( 1 << KEY_09 );
-	keys_current_sample |= chkb4_line_0_read() << KEY_09;
-	keys_current_sample &= ~( 1 << KEY_10 );
-	keys_current_sample |= chkb4_line_1_read() << KEY_10;
-	keys_current_sample &= ~( 1 << KEY_11 );
-	keys_current_sample |= chkb4_line_2_read() << KEY_11;
-	// set line 3 as input with pull-up
-	chkb4_line_3_set_hi();
-	chkb4_line_3_set_in();
-
-
-	// filter the keys pressed or released since the last keyboard update.
-	uint16_t keys_changed = keys_current_sample ^ keys_old_sample;
-
-	// further filter to get the keys that were pressed only (not released),
-	// and OR them into the flags register.
-	if( keys_changed ) key_flags |= keys_changed ^ keys_old_sample;	
+	chkb4_keys_t keys = 0;
+	uint8_t line = 1 << ( CHKB4_LINES - 1 );	// the driver line's bit, relative to line 0's bit
+	uint8_t sample;
+
+	// drive the lines last to first, shifting each line's keys in at the bottom
+	do
+	{
+		// set the line as collumn driver
+		CHKB4_PORT &= ~( line << CHKB4_LINE_0_BIT );
+		CHKB4_PDIR |= line << CHKB4_LINE_0_BIT;
+		// let the input synchroniser catch up
+		asm volatile( "nop" );
+		// read all the lines at once
+		sample = ( ~CHKB4_PIN & CHKB4_LINES_MASK ) >> CHKB4_LINE_0_BIT;
+		// set the line as input with pull-up
+		CHKB4_PDIR &= ~( line << CHKB4_LINE_0_BIT );
+		CHKB4_PORT |= line << CHKB4_LINE_0_BIT;
+		// drop the driver's own bit, packing the other lines' bits in line order
+		sample = ( sample & ( line - 1 ) ) | ( ( sample >> 1 ) & ~( line - 1 ) );
+		keys = ( keys << ( CHKB4_LINES - 1 ) ) | sample;
+	}
+	while( line >>= 1 );
+
+	return keys;
 }
 
+#else
+
+chkb4_keys_t chkb4_scan( void )
+{
+	chkb4_keys_t keys = 0, key = 1;
+	uint8_t line, sense;
+
+	for( line = 0; line < CHKB4_LINES; line++ )
+	{
+		const struct chkb4_line *driver = &chkb4_line_table[line];
+		// set the line as collumn driver
+		*driver->port &= ~driver->mask;
+		*driver->pdir |= driver->mask;
+		// read the other lines
+		for( sense = 0; sense < CHKB4_LINES; sense++ )
+		{
+			if( sense == line ) continue;
+			if( !( *chkb4_line_table[sense].pin & chkb4_line_table[sense].mask ) ) keys |= key;
+			key <<= 1;
+		}
+		// set the line as input with pull-up
+		*driver->pdir &= ~driver->mask;
+		*driver->port |= driver->mask;
+	}
+
+	return keys;
+}
+
+#endif
+
 
 
 
 /*
-	key pressed check
+	put an event into the queue
 */
 
-uint8_t chkb4_key_pressed( uint8_t key )
+void chkb4_put_event( uint8_t key, uint8_t type )
 {
-	// get the state of a single key
-	if( key_flags & ( 1 << key ) )
+	uint8_t head = chkb4_queue_head;
+	uint8_t next = ( head + 1 ) & ( CHKB4_QUEUE_SIZE - 1 );
+
+	if( next == chkb4_queue_tail ) { chkb4_overflows++; return; }
+
+	chkb4_queue[head].key = key;
+	chkb4_queue[head].type = type;
+	chkb4_queue[head].time = chkb4_time;
+
+	// publish the event only after it has been written.
+	chkb4_queue_head = next;
+}
+
+
+
+
+/*
+	keyborad update
+*/
+
+void chkb4_update( void )
+{
+	chkb4_time++;
+	if( chkb4_wake_wait ) chkb4_wake_wait--;
+
+	keys_sample = chkb4_scan();
+
+	// the keys whose sample differs from their debounced state.
+	chkb4_keys_t keys_changed = keys_sample ^ keys_state;
+
+	// the keys whose counter has reached CHKB4_DEBOUNCE - 1 (with the constant folded in at compile time).
+	chkb4_keys_t keys_count_full =
+		( ( CHKB4_DEBOUNCE - 1 ) & 1 ? keys_count_0 : ~keys_count_0 ) &
+		( ( CHKB4_DEBOUNCE - 1 ) & 2 ? keys_count_1 : ~keys_count_1 );
+
+	// change the state of the keys that differed for CHKB4_DEBOUNCE runs in a row.
+	keys_changed &= keys_count_full;
+	keys_state ^= keys_changed;
+
+	// count up the keys still differing, clear the counters of the others.
+	chkb4_keys_t keys_counting = keys_sample ^ keys_state;
+	keys_count_1 = ( keys_count_1 ^ keys_count_0 ) & keys_counting;
+	keys_count_0 = ~keys_count_0 & keys_counting;
+
+	// follow the held key for long press and auto-repeat.
+	if( chkb4_held_key != CHKB4_NO_KEY && ( keys_state & ( (chkb4_keys_t) 1 << chkb4_held_key ) ) )
 	{
-		// reset it's flag
-		key_flags &= ~( 1 << key );
+		if( chkb4_hold_time < CHKB4_LONG_DELAY && ++chkb4_hold_time == CHKB4_LONG_DELAY )
+			chkb4_put_event( chkb4_held_key, CHKB4_LONG );
+		if( --chkb4_repeat_wait == 0 )
+		{
+			chkb4_put_event( chkb4_held_key, CHKB4_REPEAT );
+			chkb4_repeat_wait = CHKB4_REPEAT_PERIOD;
+		}
+	}
 
-		return 1;
+	// the keys held since before this update, making a chord with any key pressed now.
+	chkb4_keys_t keys_chord = keys_state & ~keys_changed;
+
+	// queue a press or a release event for every changed key.
+	chkb4_keys_t keys_now = keys_state;
+	uint8_t key;
+	for( key = KEY_00; keys_changed; key++, keys_changed >>= 1, keys_now >>= 1 )
+	{
+		if( keys_changed & 1 )
+		{
+			if( keys_now & 1 )
+			{
+				chkb4_put_event( key, CHKB4_PRESS );
+				if( keys_chord ) chkb4_put_event( key, CHKB4_CHORD );
+				chkb4_held_key = key;
+				chkb4_hold_time = 0;
+				chkb4_repeat_wait = CHKB4_REPEAT_DELAY;
+			}
+			else
+			{
+				chkb4_put_event( key, CHKB4_RELEASE );
+				if( key == chkb4_held_key )
+				{
+					if( chkb4_hold_time < CHKB4_LONG_DELAY ) chkb4_put_event( key, CHKB4_SHORT );
+					chkb4_held_key = CHKB4_NO_KEY;
+				}
+			}
+		}
 	}
+}
+
+
+
+
+/*
+	get the oldest key event
+*/
 
-	return 0;
+uint8_t chkb4_get_event( struct chkb4_event *event )
+{
+	uint8_t tail = chkb4_queue_tail;
+
+	if( tail == chkb4_queue_head ) return 0;
+
+	event->key = chkb4_queue[tail].key;
+	event->type = chkb4_queue[tail].type;
+	event->time = chkb4_queue[tail].time;
+
+	// free the slot only after it has been read.
+	chkb4_queue_tail = ( tail + 1 ) & ( CHKB4_QUEUE_SIZE - 1 );
+
+	return 1;
 }
 
 
@@ -174,8 +292,115 @@ uint8_t chkb4_key_pressed( uint8_t key )
 
 uint8_t chkb4_any_key_pressed( void )
 {
-	if( key_flags ) { key_flags = 0; return 1; }
+	struct chkb4_event event;
+	uint8_t pressed = 0;
+
+	while( chkb4_get_event( &event ) ) if( event.type == CHKB4_PRESS ) pressed = 1;
+
+	return pressed;
+}
+
+
+
+
+/*
+	repeat acceleration
+*/
+
+const uint8_t chkb4_accel_table[] PROGMEM = { CHKB4_ACCEL_STEPS };
+uint16_t chkb4_accel_time;
+
+uint8_t chkb4_accel( struct chkb4_event *event )
+{
+	uint16_t held;
+
+	if( event->type == CHKB4_PRESS )
+	{
+		chkb4_accel_time = event->time;
+		return 1;
+	}
+	held = (uint16_t)( event->time - chkb4_accel_time ) >> CHKB4_ACCEL_SHIFT;
+	if( held >= sizeof( chkb4_accel_table ) ) held = sizeof( chkb4_accel_table ) - 1;
+	return pgm_read_byte_near( chkb4_accel_table + held );
+}
+
+
+
+
+/*
+	keyboard idle check
+*/
+
+uint8_t chkb4_idle( void )
+{
+	// a key still being debounced counts as held, as does a key that has just woken the MCU up.
+	return ( keys_state | keys_sample ) == 0 && chkb4_queue_head == chkb4_queue_tail && !chkb4_wake_wait;
+}
+
+
+
+
+/*
+	arm the wake up on key press
+*/
 
-	return 0;
+void chkb4_wake_arm( void )
+{
+	// drive the last line low. The other lines stay inputs with pull-ups, pulled low by the last line's keys.
+	// enable their pin change interrupts, clearing any stale flag first.
+#ifdef CHKB4_SHARED_PORT
+	CHKB4_PORT &= ~( 1 << ( CHKB4_LINE_0_BIT + CHKB4_LINES - 1 ) );
+	CHKB4_PDIR |= 1 << ( CHKB4_LINE_0_BIT + CHKB4_LINES - 1 );
+	CHKB4_PCMSK |= ( CHKB4_LINES_MASK >> 1 ) & CHKB4_LINES_MASK;
+	PCIFR = 1 << CHKB4_PCIE;
+	PCICR |= 1 << CHKB4_PCIE;
+#else
+	const struct chkb4_line *driver = &chkb4_line_table[CHKB4_LINES - 1];
+	uint8_t line;
+	*driver->port &= ~driver->mask;
+	*driver->pdir |= driver->mask;
+	for( line = 0; line < CHKB4_LINES - 1; line++ )
+	{
+		*chkb4_line_table[line].pcmsk |= chkb4_line_table[line].mask;
+		PCIFR = 1 << chkb4_line_table[line].pcie;
+		PCICR |= 1 << chkb4_line_table[line].pcie;
+	}
+#endif
 }
 
+
+
+
+/*
+	disarm the wake up on key press
+*/
+
+void chkb4_wake_disarm( void )
+{
+#ifdef CHKB4_SHARED_PORT
+	CHKB4_PCMSK &= ~( ( CHKB4_LINES_MASK >> 1 ) & CHKB4_LINES_MASK );
+#else
+	uint8_t line;
+	for( line = 0; line < CHKB4_LINES - 1; line++ )
+		*chkb4_line_table[line].pcmsk &= ~chkb4_line_table[line].mask;
+#endif
+
+	// set the last line back to input with pull-up
+	chkb4_init();
+}
+
+
+
+
+/*
+	wake up interrupt
+
+	Keeps the keyboard from being idle until the key that woke the MCU up has been scanned
+	for CHKB4_DEBOUNCE + 1 runs, so that its press is queued before the MCU can sleep again.
+	A held key makes no new edge to wake it up with.
+*/
+
+ISR( CHKB4_WAKE_vect )
+{
+	chkb4_wake_wait = CHKB4_DEBOUNCE + 1;
+}
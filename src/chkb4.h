@@ -1,39 +1,70 @@
 /*
-	The keyboard is using 4 dedicated I/O lines to implement 12 keys.
+	The keyboard is using N dedicated I/O lines to implement N * (N - 1) keys (charlieplexed, with diodes).
+	4 lines implement 12 keys, 5 lines 20 keys. The number of lines is set by CHKB4_LINES.
 	The I/O lines can be configured indepentently from any available port.
 
 	Before the keyboard can be used the chkb4_init() function has to be called.
 
-	The keyboard system is using 3 16-bit registers for keeping key information.
-	Each bit of a register corresponds to a key. 1 means pressed, 0 means not pressed.
-	Only 12 bits (0 through 11) are being used.
+	The keyboard system is using registers of type 'chkb4_keys_t' for keeping key information
+	(16-bit for up to 4 lines, 32-bit for more). Each bit of a register corresponds to a key.
+	Only N * (N - 1) bits are being used.
 
-	'keys_current_sample' is holding the keys status aquired by the last run of the chkb4_update() function.
-	'keys_old_sample' is holding the keys status aquired by the prevous to the last run of chkb4_update().
-	'keys_flags' is holding a flag for each key. The key's flag will be set when the key is pressed
-	(i.e. a transition from 0 to 1 in the 'keys_current_sample' register). It will not be set when
-	the key is released (i.e. transition from 1 to 0). The flag will be reset only via either the chkb4_key_pressed()
-	or the chkb4_any_key_pressed() functions call.
+	'keys_sample' is holding the raw keys status aquired by the last run of the chkb4_update() function.
+	'keys_state' is holding the debounced keys status. 1 means pressed, 0 means not pressed.
 
-	The chkb4_update() function must be called periodically (usually via a timer interrupt) with a period
-	of no less than 20ms (a safe value), to facillate key debouncing.
-	Prior to scanning, the previous 'keys_current_sample' value is saved into 'keys_old_sample'.
+	The chkb4_update() function must be called periodically (usually via a timer interrupt),
+	every CHKB4_PERIOD_US microseconds. Set CHKB4_PERIOD_US to match the timer.
 	The function scans the I/O lines using the following pattern:
-	The first I/O line is set as output. The other 3 lines are set as inputs and are getting sampled indepentently.
-	If a key is found to be pressed, the corresponding 'keys_current_sample' register's bit will be set to 1.
+	The first I/O line is set as output, driven low. The other lines are inputs with pull-ups and are sampled.
+	A pressed key pulls its line low, setting the corresponding 'keys_sample' register's bit to 1.
 	The procedure is repeated for all I/O lines (i.e. the next line is set as output, etc).
-	Next, a XOR operation between 'keys_current_sample' and 'keys_old_sample' will reveal if there was any key
-	state changed (i.e pressed or released), by indicating 1 for a change and 0 for no change.
-	If change is detected, a second XOR operation between the first XOR result (key changes) and 'keys_old_sample',
-	will reveal which keys were pressed (not released). This information is ORed into the 'key_flags' variable.
-
-	The idea behind the 'key_flags' register, is to have a mechanism similar to interrupt flags.
-	If a key is pressed, a flag is raised until the key is serviced.
-
-	The chkb4_key_pressed() function checks if a specific key has it's flag set. It also resets that key's flag.
-	The argument is the key's name as a macro, defined bellow in the 'key names' section.
-
-	The chkb4_any_key_pressed() function checks if any key has it's flag set. It also resets all the key flags.
+	Line 'i' as the driver gives keys i * (N - 1) to i * (N - 1) + N - 2, one for each other line, in line order.
+
+	The scan is driven by a table of the lines' registers, built at compile time from the setup bellow.
+	When CHKB4_SHARED_PORT is defined, all the lines must be on the port of line 0, at consecutive bits
+	starting with line 0's bit. The table is then not used. All the lines are sampled with a single
+	port read per driver line, and the sample's bits are packed into the key bits with a few shifts.
+
+	The keys are debounced by integration: a key's state changes only after its sample has differed from
+	the state for CHKB4_DEBOUNCE runs in a row. Each key has a 2-bit counter of these runs, kept as a
+	'vertical counter': bit 0 of all the counters is held in 'keys_count_0' and bit 1 in 'keys_count_1',
+	so all the keys are counted at once with a few bitwise operations, without a loop over the keys.
+	A counter is cleared whenever the sample agrees with the state, so contact bounce shorter than
+	CHKB4_DEBOUNCE runs never reaches the state. The press latency is CHKB4_DEBOUNCE runs.
+	For every key whose state changed a press or a release event is put into the key event queue.
+
+	The key event queue is a single producer / single consumer ring buffer. chkb4_update() (the interrupt)
+	is the only writer of the queue's head and the main loop the only writer of its tail, both single bytes,
+	so neither side has to disable interrupts. Every event holds the key, the event type and the value of
+	'chkb4_time', the count of chkb4_update() runs, at the time of the event.
+	Repeated presses are queued as separate events. If the queue is full, the event is dropped
+	and 'chkb4_overflows' is incremented.
+
+	The last key pressed is followed while it is held. After CHKB4_LONG_DELAY runs of chkb4_update()
+	a long press event is queued. After CHKB4_REPEAT_DELAY runs a repeat event is queued,
+	and then another one every CHKB4_REPEAT_PERIOD runs, until the key is released.
+	Pressing another key starts following that key instead.
+	When the followed key is released before its long press event, a short press event is queued
+	after the release event. A key pressed while other keys are held gets a chord event after its
+	press event. The chord event does not tell which other keys are held.
+
+	The chkb4_get_event() function takes the oldest event out of the queue.
+
+	The chkb4_accel() function turns a press or repeat event of a held key into a count of steps to make,
+	1 for the press, then growing with the time the key has been held, by CHKB4_ACCEL_STEPS, to the next
+	entry every 2^CHKB4_ACCEL_SHIFT runs. Only one key can be accelerated at a time.
+
+	The chkb4_any_key_pressed() function empties the queue and reports whether there was any key press in it.
+
+	Idle mode lets the MCU sleep with chkb4_update() stopped, until a key is pressed.
+	chkb4_idle() reports whether the keyboard is idle (no key held, no event queued and no wake up pending).
+	chkb4_wake_arm() drives the last line low and enables the pin change interrupts of the other lines,
+	so that pressing one of the keys driven by the last line (KEY_09, KEY_10 or KEY_11 with 4 lines)
+	wakes the MCU up.
+	The other keys can't be sensed without scanning. chkb4_wake_disarm() restores the lines for scanning.
+	The key press itself is picked up by chkb4_update() once scanning is resumed: the wake up interrupt
+	keeps chkb4_idle() false for the next CHKB4_DEBOUNCE + 1 runs, so that the press is debounced and queued
+	before the MCU can go back to sleep. A wake up by the UART, sharing the interrupt, counts the same.
 */
 
 #ifndef __CHKB4__
@@ -41,6 +72,7 @@
 
 #include <stdint.h>
 #include <avr/io.h>
+#include "delay.h"
 
 
 
@@ -49,31 +81,59 @@
 	Setup
 */
 
-// Keyboard lines port, direction, pin registers and bit position (0 lsbit, 7 msbit)
+// Number of keyboard lines.
+#define CHKB4_LINES 4
+
+// All the lines are on the port of line 0, at consecutive bits. Comment out otherwise.
+#define CHKB4_SHARED_PORT
+
+// Keyboard lines port, direction, pin registers and bit position (0 lsbit, 7 msbit),
+// pin change mask register and pin change interrupt enable bit.
+// PD0 and PD1 are the UART's.
 
 // line 0
 #define CHKB4_LINE_0_PORT PORTD
 #define CHKB4_LINE_0_PDIR DDRD
 #define CHKB4_LINE_0_PIN PIND
-#define CHKB4_LINE_0_BIT 0
+#define CHKB4_LINE_0_BIT 4
+#define CHKB4_LINE_0_PCMSK PCMSK2
+#define CHKB4_LINE_0_PCIE PCIE2
 
 // line 1
 #define CHKB4_LINE_1_PORT PORTD
 #define CHKB4_LINE_1_PDIR DDRD
 #define CHKB4_LINE_1_PIN PIND
-#define CHKB4_LINE_1_BIT 1
+#define CHKB4_LINE_1_BIT 5
+#define CHKB4_LINE_1_PCMSK PCMSK2
+#define CHKB4_LINE_1_PCIE PCIE2
 
 // line 2
 #define CHKB4_LINE_2_PORT PORTD
 #define CHKB4_LINE_2_PDIR DDRD
 #define CHKB4_LINE_2_PIN PIND
-#define CHKB4_LINE_2_BIT 2
+#define CHKB4_LINE_2_BIT 6
+#define CHKB4_LINE_2_PCMSK PCMSK2
+#define CHKB4_LINE_2_PCIE PCIE2
 
 // line 3
 #define CHKB4_LINE_3_PORT PORTD
 #define CHKB4_LINE_3_PDIR DDRD
 #define CHKB4_LINE_3_PIN PIND
-#define CHKB4_LINE_3_BIT 3
+#define CHKB4_LINE_3_BIT 7
+#define CHKB4_LINE_3_PCMSK PCMSK2
+#define CHKB4_LINE_3_PCIE PCIE2
+
+// line 4 (used only with 5 lines, without CHKB4_SHARED_PORT)
+#define CHKB4_LINE_4_PORT PORTB
+#define CHKB4_LINE_4_PDIR DDRB
+#define CHKB4_LINE_4_PIN PINB
+#define CHKB4_LINE_4_BIT 0
+#define CHKB4_LINE_4_PCMSK PCMSK0
+#define CHKB4_LINE_4_PCIE PCIE0
+
+// Pin change interrupt vector of the lines sensed while waiting for a key in idle mode (all but the last).
+
+#define CHKB4_WAKE_vect PCINT2_vect
 
 //	Key names and bit positions in chkb4 registers
 
@@ -89,6 +149,80 @@
 #define KEY_09 9
 #define KEY_10 10
 #define KEY_11 11
+#define KEY_12 12
+#define KEY_13 13
+#define KEY_14 14
+#define KEY_15 15
+#define KEY_16 16
+#define KEY_17 17
+#define KEY_18 18
+#define KEY_19 19
+
+//	Key registers type, wide enough for all the keys.
+
+#if CHKB4_LINES > 4
+typedef uint32_t chkb4_keys_t;
+#else
+typedef uint16_t chkb4_keys_t;
+#endif
+
+
+
+
+//	chkb4_update() period in microseconds (timer 0 overflow with the 1/256 prescaler set up in main.c,
+//	8.2ms at 8MHz), and the count of chkb4_update() runs in 'ms' milliseconds.
+
+#define CHKB4_PERIOD_US ( 256UL * 256 * 1000000 / F_CPU )
+#define CHKB4_MS( ms ) ( (uint32_t)( ms ) * 1000 / CHKB4_PERIOD_US )
+
+//	Debounce integration time, in chkb4_update() runs (1 - 4).
+
+#define CHKB4_DEBOUNCE 3			// 24.6ms
+
+//	Long press and auto-repeat delays, in chkb4_update() runs (up to 255).
+
+#define CHKB4_LONG_DELAY CHKB4_MS( 600 )
+#define CHKB4_REPEAT_DELAY CHKB4_MS( 400 )
+#define CHKB4_REPEAT_PERIOD CHKB4_MS( 100 )
+
+//	Repeat acceleration: the steps per repeat event, growing to the next entry every 2^CHKB4_ACCEL_SHIFT runs held.
+
+#define CHKB4_ACCEL_SHIFT 7			// 1.05s
+#define CHKB4_ACCEL_STEPS 1, 2, 5, 10, 20, 50
+
+//	Key event queue size (a power of 2), holding up to CHKB4_QUEUE_SIZE - 1 events.
+
+#define CHKB4_QUEUE_SIZE 8
+
+
+
+
+/*
+	Key events
+*/
+
+// event types
+#define CHKB4_PRESS 0
+#define CHKB4_RELEASE 1
+#define CHKB4_LONG 2
+#define CHKB4_REPEAT 3
+#define CHKB4_SHORT 4
+#define CHKB4_CHORD 5
+
+#define CHKB4_EVENT_TYPES 6
+
+struct chkb4_event
+{
+	uint8_t key;	// key name.
+	uint8_t type;	// event type.
+	uint16_t time;	// 'chkb4_time' at the event.
+};
+
+// count of chkb4_update() runs.
+extern volatile uint16_t chkb4_time;
+
+// count of events dropped because the queue was full.
+extern volatile uint8_t chkb4_overflows;
 
 
 
@@ -99,8 +233,12 @@
 
 void chkb4_init( void );
 void chkb4_update( void );
-uint8_t chkb4_key_pressed( uint8_t key );
+uint8_t chkb4_get_event( struct chkb4_event *event );
+uint8_t chkb4_accel( struct chkb4_event *event );
 uint8_t chkb4_any_key_pressed( void );
+uint8_t chkb4_idle( void );
+void chkb4_wake_arm( void );
+void chkb4_wake_disarm( void );
 
 #endif
 
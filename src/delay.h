@@ -1,7 +1,14 @@
 /*
 	A simple delay loop using an assembly routine with known number of cycles per iterration.
 	Macros are being defined to fixed delay values which can be used as arguments to the delay function.
-	It is important that the system's clock frequency be set accordingly bellow.
+	The delays are computed from the system's clock frequency F_CPU, normally given by the Makefile.
+
+	All the delay values are integer constant expressions, rounded up to whole loop iterrations,
+	so a delay is never shorter than asked. A value out of the delay loop's range (0 iterrations,
+	or more than 2^32) fails to compile.
+
+	Sub-microsecond delays, e.g. for bus timing, use 'delay_ns()', which is expanded inline into
+	the exact number of cycles (rounded up), without a call.
 */
 
 #ifndef __DELAY__
@@ -13,28 +20,68 @@
 
 
 /*
-    Set the system's clock frequency in Hz.
+    The system's clock frequency in Hz, if not given by the Makefile.
 */
 
-#define CLKFREQ 8000000
+#ifndef F_CPU
+#define F_CPU 8000000UL
+#endif
+
+#if F_CPU % 1000 != 0
+#error "F_CPU must be a multiple of 1kHz"
+#endif
+
+#if F_CPU < 1000000 || F_CPU > 20000000
+#error "F_CPU must be 1MHz - 20MHz"
+#endif
+
+
+
 
 /*
-    Pre-calculated delays based on system's clock frequency.
-    Min delay in seconds = 6 / CLKFREQ
-    Max delay in seconds = (2^32 * 6) / CLKFREQ
+    Delay loop iterrations for a delay in microseconds or milliseconds, and cycles for a delay in nanoseconds.
+    Min delay in seconds = 6 / F_CPU
+    Max delay in seconds = (2^32 * 6) / F_CPU
 */
 
-#define   _1us_ ((0.000001f * CLKFREQ) / 6)
-#define  _30us_ ((0.00003f * CLKFREQ) / 6)
-#define _300us_ ((0.0003f * CLKFREQ) / 6)
-#define   _1ms_ ((0.001f * CLKFREQ) / 6)
-#define   _2ms_ ((0.002f * CLKFREQ) / 6)
-#define  _10ms_ ((0.01f * CLKFREQ) / 6)
-#define _100ms_ ((0.1f * CLKFREQ) / 6)
-#define _110ms_ ((0.11f * CLKFREQ) / 6)
-#define _120ms_ ((0.12f * CLKFREQ) / 6)
-#define _200ms_ ((0.2f * CLKFREQ) / 6)
-#define _300ms_ ((0.3f * CLKFREQ) / 6)
+#define DELAY_LOOP_CYCLES 6
+
+#define DELAY_CYCLES_NS( ns ) ( (uint32_t)( ( (uint64_t)( ns ) * ( F_CPU / 1000UL ) + 999999UL ) / 1000000UL ) )
+#define DELAY_CYCLES_US( us ) ( ( (uint64_t)( us ) * ( F_CPU / 1000UL ) + 999UL ) / 1000UL )
+#define DELAY_CYCLES_MS( ms ) ( (uint64_t)( ms ) * ( F_CPU / 1000UL ) )
+
+// Loop iterrations for 'cycles', failing to compile (negative array size) when out of range.
+#define DELAY_LOOPS( cycles ) \
+	( (void) sizeof( char[ ( cycles ) >= 1 && ( cycles ) <= 0xffffffffULL * DELAY_LOOP_CYCLES ? 1 : -1 ] ), \
+	  (uint32_t)( ( ( cycles ) + DELAY_LOOP_CYCLES - 1 ) / DELAY_LOOP_CYCLES ) )
+
+#define DELAY_US( us ) DELAY_LOOPS( DELAY_CYCLES_US( us ) )
+#define DELAY_MS( ms ) DELAY_LOOPS( DELAY_CYCLES_MS( ms ) )
+
+/*
+    Pre-calculated delays.
+*/
+
+#define   _1us_ DELAY_US( 1 )
+#define  _30us_ DELAY_US( 30 )
+#define _300us_ DELAY_US( 300 )
+#define   _1ms_ DELAY_MS( 1 )
+#define   _2ms_ DELAY_MS( 2 )
+#define  _10ms_ DELAY_MS( 10 )
+#define _100ms_ DELAY_MS( 100 )
+#define _110ms_ DELAY_MS( 110 )
+#define _120ms_ DELAY_MS( 120 )
+#define _200ms_ DELAY_MS( 200 )
+#define _300ms_ DELAY_MS( 300 )
+
+
+
+
+/*
+    Inline delay of at least 'ns' nanoseconds (a constant, up to 1ms), exact to a cycle.
+*/
+
+#define delay_ns( ns ) __builtin_avr_delay_cycles( DELAY_CYCLES_NS( ns ) )
 
 
 /*
@@ -44,4 +91,3 @@
 void delay(uint32_t delay);
 
 #endif
-
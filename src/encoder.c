@@ -0,0 +1,142 @@
+#include "encoder.h"
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+
+
+
+/*
+	Globals
+*/
+
+// last state of the lines (A in bit 0, B in bit 1), quarter steps towards the next detent, detents not read yet.
+uint8_t encoder_state;
+int8_t encoder_quarters;
+volatile int8_t encoder_detents;
+
+volatile uint8_t encoder_errors;
+
+// quarter step for every old state * 4 + new state. ENCODER_INVALID marks a missed state.
+#define ENCODER_INVALID 2
+
+#define X ENCODER_INVALID
+
+const int8_t encoder_table[16] PROGMEM = {
+	//	new state
+	//	00	01	10	11		old state
+		0,	1,	-1,	X,		// 00
+		-1,	0,	X,	1,		// 01
+		1,	X,	0,	-1,		// 10
+		X,	-1,	1,	0		// 11
+};
+
+#undef X
+
+// channels per detent, for 1, 2, 3 ... detents per ENCODER_PERIOD_MS.
+const uint8_t encoder_accel_table[] PROGMEM = { 1, 1, 2, 3, 5, 8, 12, 20 };
+
+
+
+
+/*
+	encoder lines read
+
+	Returns the state of the lines, A in bit 0 and B in bit 1, 1 for a closed contact.
+*/
+
+uint8_t encoder_lines( void )
+{
+	uint8_t pin = ~ENCODER_PIN;
+
+	return ( ( pin >> ENCODER_A_BIT ) & 1 ) | ( ( ( pin >> ENCODER_B_BIT ) & 1 ) << 1 );
+}
+
+
+
+
+/*
+	encoder I/O initialise
+*/
+
+void encoder_init( void )
+{
+	// set the lines to input with pull-ups
+	ENCODER_PDIR &= ~( ( 1 << ENCODER_A_BIT ) | ( 1 << ENCODER_B_BIT ) );
+	ENCODER_PORT |= ( 1 << ENCODER_A_BIT ) | ( 1 << ENCODER_B_BIT );
+
+	encoder_state = encoder_lines();
+
+	// enable the pin change interrupts of the lines, clearing any stale flag first.
+	ENCODER_PCMSK |= ( 1 << ENCODER_A_BIT ) | ( 1 << ENCODER_B_BIT );
+	PCIFR = 1 << ENCODER_PCIE;
+	PCICR |= 1 << ENCODER_PCIE;
+}
+
+
+
+
+/*
+	encoder pin change interrupt
+*/
+
+ISR( ENCODER_vect )
+{
+	uint8_t state = encoder_lines();
+	int8_t quarter = pgm_read_byte( &encoder_table[( encoder_state << 2 ) | state] );
+
+	encoder_state = state;
+
+	if( quarter == ENCODER_INVALID ) { encoder_errors++; return; }
+
+	encoder_quarters += quarter;
+
+	if( encoder_quarters >= ENCODER_STEPS )
+	{
+		encoder_quarters = 0;
+		if( encoder_detents < 127 ) encoder_detents++;
+	}
+	else if( encoder_quarters <= -ENCODER_STEPS )
+	{
+		encoder_quarters = 0;
+		if( encoder_detents > -127 ) encoder_detents--;
+	}
+}
+
+
+
+
+/*
+	read and clear the detents turned
+*/
+
+int8_t encoder_read( void )
+{
+	int8_t detents;
+	uint8_t sreg = SREG;
+
+	cli();
+	detents = encoder_detents;
+	encoder_detents = 0;
+	SREG = sreg;
+
+	return detents;
+}
+
+
+
+
+/*
+	velocity scaling
+
+	Returns the channels to step for 'detents' turned in ENCODER_PERIOD_MS.
+*/
+
+int16_t encoder_steps( int8_t detents )
+{
+	uint8_t speed = detents < 0 ? -detents : detents;
+
+	if( speed == 0 ) return 0;
+	if( speed > sizeof( encoder_accel_table ) ) speed = sizeof( encoder_accel_table );
+
+	return detents * (int16_t) pgm_read_byte( &encoder_accel_table[speed - 1] );
+}
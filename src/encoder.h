@@ -0,0 +1,70 @@
+/*
+	Quadrature rotary encoder driver.
+
+	The encoder's A and B contacts are on two I/O lines of the same port, inputs with pull-ups,
+	both with pin change interrupts enabled. Before the encoder can be used the encoder_init() function
+	has to be called.
+
+	Every pin change runs the interrupt, which reads both lines and looks the transition from the previous
+	state to the new one up in a 16 entry table (indexed by old state * 4 + new state). A valid transition
+	moves the position by one quarter step up or down. A transition with both lines changed means that a
+	state was missed, it is counted in 'encoder_errors' and ignored. Contact bounce just moves the position
+	back and forth between two neighbouring states, so it needs no debouncing.
+	Every ENCODER_STEPS quarter steps in the same direction make a detent, which is added to the detent
+	count returned by encoder_read().
+
+	encoder_read() returns the detents turned since its last call and clears the count.
+	The count saturates at +-127, so the main loop can read it whenever it is ready: all the detents
+	turned in the meantime are taken at once (latest wins), instead of one tuning per detent.
+
+	encoder_steps() applies velocity scaling. Called with the detents read every ENCODER_PERIOD_MS,
+	slow turning steps one channel per detent and faster turning more channels per detent.
+*/
+
+#ifndef __ENCODER__
+#define __ENCODER__
+
+#include <stdint.h>
+#include <avr/io.h>
+
+
+
+
+/*
+	Setup
+*/
+
+// Encoder lines port, direction, pin registers and bit positions (0 lsbit, 7 msbit).
+// PB6 and PB7 are free, as the MCU runs on the internal RC oscillator.
+#define ENCODER_PORT PORTB
+#define ENCODER_PDIR DDRB
+#define ENCODER_PIN PINB
+#define ENCODER_A_BIT 6
+#define ENCODER_B_BIT 7
+
+// Pin change mask register, interrupt enable bit and vector of the encoder lines.
+#define ENCODER_PCMSK PCMSK0
+#define ENCODER_PCIE PCIE0
+#define ENCODER_vect PCINT0_vect
+
+// Quarter steps per detent (4 for most mechanical encoders, 2 or 1 for some).
+#define ENCODER_STEPS 4
+
+// Period in milliseconds, at which the main loop is expected to call encoder_read() for encoder_steps().
+#define ENCODER_PERIOD_MS 50
+
+
+
+
+/*
+	API
+*/
+
+// count of invalid transitions (missed states).
+extern volatile uint8_t encoder_errors;
+
+void encoder_init( void );
+int8_t encoder_read( void );
+int16_t encoder_steps( int8_t detents );
+
+#endif
@@ -0,0 +1,133 @@
+/*
+    Signal history.
+*/
+
+#include "history.h"
+
+
+
+
+/*
+    Globals
+*/
+
+uint8_t history_count;
+
+// packed samples, and the slot the next sample goes to.
+uint8_t history_rssi[HISTORY_SIZE * 7 / 8];
+uint8_t history_snr[HISTORY_SIZE * 7 / 8];
+uint8_t history_head;
+
+
+
+
+/*
+    7 bit packing
+
+    Sample 'slot' takes bits 7 * slot to 7 * slot + 6 of the buffer, low bits first,
+    and straddles two bytes unless it starts at bit 0 or 1 of a byte.
+*/
+
+uint8_t history_unpack(const uint8_t *buffer, uint8_t slot)
+{
+  uint16_t bit = slot * 7;
+  uint8_t byte = bit >> 3, shift = bit & 0x07;
+  uint16_t bits = buffer[byte];
+
+  if(shift > 1) bits |= buffer[byte + 1] << 8;
+  return (bits >> shift) & 0x7f;
+}
+
+void history_pack(uint8_t *buffer, uint8_t slot, uint8_t value)
+{
+  uint16_t bit = slot * 7;
+  uint8_t byte = bit >> 3, shift = bit & 0x07;
+  uint16_t bits = buffer[byte], mask = 0x7f << shift;
+
+  if(shift > 1) bits |= buffer[byte + 1] << 8;
+  bits = (bits & ~mask) | ((uint16_t) (value & 0x7f) << shift);
+  buffer[byte] = bits;
+  if(shift > 1) buffer[byte + 1] = bits >> 8;
+}
+
+
+
+
+/*
+    Ring
+*/
+
+void history_clear(void)
+{
+  history_count = 0;
+  history_head = 0;
+}
+
+void history_add(uint8_t rssi, uint8_t snr)
+{
+  history_pack(history_rssi, history_head, rssi);
+  history_pack(history_snr, history_head, snr);
+  if(++history_head == HISTORY_SIZE) history_head = 0;
+  if(history_count < HISTORY_SIZE) history_count++;
+}
+
+void history_get(uint8_t age, uint8_t *rssi, uint8_t *snr)
+{
+  uint8_t slot = (history_head > age) ? history_head - age - 1 : history_head + HISTORY_SIZE - age - 1;
+
+  *rssi = history_unpack(history_rssi, slot);
+  *snr = history_unpack(history_snr, slot);
+}
+
+
+
+
+/*
+    Graph
+
+    A column is 16 pixels, bit 0 the top pixel of line HISTORY_LINE, bit 15 the bottom pixel of the line below.
+    Empty slots and the slot the next sample goes to (the sweep position) are blank.
+    Every slot is drawn HISTORY_WIDTH columns wide.
+*/
+
+uint16_t history_column(uint8_t slot)
+{
+  uint8_t rssi, snr;
+
+  if(slot == history_head || (history_count < HISTORY_SIZE && slot >= history_count)) return 0x0000;
+  rssi = history_unpack(history_rssi, slot) >> 3;
+  snr = history_unpack(history_snr, slot) >> 1;
+  if(snr > 15) snr = 15;
+  return (uint16_t) ~(0xffffU >> rssi) ^ (0x8000U >> snr);
+}
+
+void history_draw_last(void)
+{
+  uint8_t last = (history_head ? history_head : HISTORY_SIZE) - 1, page, i;
+  uint16_t column = history_column(last);
+
+  if(!history_count) return;
+  for(page = 0; page < 2; page++)
+  {
+    uc1701_cursor_move_px(HISTORY_LINE + page, HISTORY_X + last * HISTORY_WIDTH);
+    for(i = 0; i < HISTORY_WIDTH; i++) uc1701_print_column(column >> (page * 8));
+    if(!history_head) uc1701_cursor_move_px(HISTORY_LINE + page, HISTORY_X);
+    for(i = 0; i < HISTORY_WIDTH; i++) uc1701_print_column(0x00);
+  }
+}
+
+void history_draw(void)
+{
+  uint8_t slot, page, i;
+  uint16_t column;
+
+  for(page = 0; page < 2; page++)
+  {
+    uc1701_cursor_move_px(HISTORY_LINE + page, HISTORY_X);
+    for(slot = 0; slot < HISTORY_SIZE; slot++)
+    {
+      column = history_column(slot) >> (page * 8);
+      for(i = 0; i < HISTORY_WIDTH; i++) uc1701_print_column(column);
+    }
+  }
+}
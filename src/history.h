@@ -0,0 +1,99 @@
+/*
+    Signal history: the last HISTORY_SIZE RSSI / SNR samples, and their trend graph on the UC1701 display.
+
+    Both values are 0 - 127, so they are kept packed 7 bits to a sample, 8 samples in 7 bytes,
+    in a ring of HISTORY_SIZE samples per value (2 * HISTORY_SIZE * 7 / 8 bytes in all).
+
+    The graph is two display lines (16 pixels) high and HISTORY_SIZE * HISTORY_WIDTH pixels wide,
+    HISTORY_WIDTH columns per ring slot: the RSSI is drawn as a bar from the bottom, 8dBuV per pixel,
+    the SNR as a single pixel inverted over it, 2dB per pixel. The controller can't scroll horizontally,
+    so the graph sweeps instead: each new sample is drawn at its slot's columns, followed by blank columns
+    marking the sweep position, which costs 14 bytes on the bus per sample (2 address commands
+    and 4 columns for each line, 20 bytes at the wrap).
+    The whole graph is only drawn to restore the screen.
+*/
+
+#ifndef __HISTORY__
+#define __HISTORY__
+
+#include <stdint.h>
+#include "uc1701.h"
+
+
+
+
+/*
+    Setup
+*/
+
+// Number of samples kept, a multiple of 8, and the pixel columns drawn per sample.
+#define HISTORY_SIZE 48
+#define HISTORY_WIDTH 2
+
+// Top display line and first pixel column of the graph.
+#define HISTORY_LINE 6
+#define HISTORY_X 0
+
+
+
+
+/*
+    Globals
+*/
+
+// Number of samples kept so far (up to HISTORY_SIZE).
+extern uint8_t history_count;
+
+
+
+
+/*
+    API
+*/
+
+/*
+    Forget all the samples. Nothing is drawn.
+*/
+
+void history_clear(void);
+
+
+
+
+/*
+    Add a sample, overwriting the oldest one when the ring is full. Nothing is drawn.
+*/
+
+void history_add(uint8_t rssi, uint8_t snr);
+
+
+
+
+/*
+    Get the sample 'age' samples older than the last one added (0 - history_count - 1).
+*/
+
+void history_get(uint8_t age, uint8_t *rssi, uint8_t *snr);
+
+
+
+
+/*
+    Draw the last sample added, and the sweep position after it.
+*/
+
+void history_draw_last(void);
+
+
+
+
+/*
+    Draw the whole graph.
+*/
+
+void history_draw(void);
+
+
+
+
+#endif
@@ -0,0 +1,31 @@
+/*
+	Icon bitmaps for the UC1701 display, drawn with 'uc1701_blit_P()'.
+
+	Stored page after page, one byte per column, bit 0 at the top.
+*/
+
+#ifndef __ICONS__
+#define __ICONS__
+
+#include <avr/pgmspace.h>
+
+
+
+
+/*
+	Stereo / mono indicator, 13 x 8 pixels.
+*/
+
+#define ICON_STEREO_WIDTH 13
+#define ICON_STEREO_HEIGHT 8
+
+const char icon_stereo[] PROGMEM = {
+                                     0x3c, 0x42, 0x81, 0x81, 0x81, 0xbd, 0x42, 0xbd, 0x81, 0x81, 0x81, 0x42, 0x3c
+                                   };
+
+const char icon_mono[] PROGMEM = {
+                                   0x00, 0x00, 0x3c, 0x42, 0x81, 0x81, 0x81, 0x81, 0x42, 0x3c, 0x00, 0x00, 0x00
+                                 };
+
+
+#endif
@@ -0,0 +1,119 @@
+/*
+	Keymap: the action of every key event, looked up by 'keymap_dispatch()' in main.c.
+
+	The map has a layer for every screen taking keys, and within a layer an action for every
+	event type and key. Entries not listed are ACTION_NONE.
+
+	Any entry can be overridden without reflashing, by writing the action into the same entry
+	of 'keymap_ee' in the EEPROM. Erased EEPROM entries (KEYMAP_DEFAULT) keep the action below.
+*/
+
+#ifndef __KEYMAP__
+#define __KEYMAP__
+
+#include <avr/pgmspace.h>
+#include <avr/eeprom.h>
+#include "chkb4.h"
+
+
+
+
+/*
+	Actions, indexes of 'action_table' in main.c.
+*/
+
+#define ACTION_NONE 0
+#define ACTION_TUNE_UP 1
+#define ACTION_TUNE_DOWN 2
+#define ACTION_SCAN_UP 3
+#define ACTION_SCAN_DOWN 4
+#define ACTION_FM 5
+#define ACTION_MW 6
+#define ACTION_SW 7
+#define ACTION_OFF 8
+#define ACTION_LOG_OPEN 9
+#define ACTION_LOG_CLOSE 10
+#define ACTION_LOG_UP 11
+#define ACTION_LOG_DOWN 12
+#define ACTION_VOLUME_UP 13
+#define ACTION_VOLUME_DOWN 14
+#define ACTION_ENTRY_OPEN 15
+#define ACTION_ENTRY_DIGIT 16		// the digit is the key's number, KEY_00 - KEY_09.
+#define ACTION_ENTRY_BACK 17
+#define ACTION_ENTRY_ENTER 18
+#define ACTION_ENTRY_CANCEL 19
+#define ACTION_SWEEP_UP 20
+#define ACTION_SWEEP_DOWN 21
+
+#define ACTIONS 22
+
+
+
+
+/*
+	Layers
+*/
+
+#define KEYMAP_MAIN 0		// main screen
+#define KEYMAP_LOG 1		// scan log list view
+#define KEYMAP_ENTRY 2		// frequency entry
+
+#define KEYMAP_LAYERS 3
+
+#define KEYMAP_KEYS ( CHKB4_LINES * ( CHKB4_LINES - 1 ) )
+
+// EEPROM entry value keeping the default action.
+#define KEYMAP_DEFAULT 0xff
+
+
+
+
+/*
+	Default keymap
+*/
+
+const uint8_t keymap[KEYMAP_LAYERS][CHKB4_EVENT_TYPES][KEYMAP_KEYS] PROGMEM = {
+
+	[KEYMAP_MAIN][CHKB4_PRESS][KEY_04] = ACTION_TUNE_UP,
+	[KEYMAP_MAIN][CHKB4_PRESS][KEY_01] = ACTION_TUNE_DOWN,
+	[KEYMAP_MAIN][CHKB4_REPEAT][KEY_04] = ACTION_TUNE_UP,
+	[KEYMAP_MAIN][CHKB4_REPEAT][KEY_01] = ACTION_TUNE_DOWN,
+	[KEYMAP_MAIN][CHKB4_SHORT][KEY_05] = ACTION_SCAN_UP,
+	[KEYMAP_MAIN][CHKB4_SHORT][KEY_02] = ACTION_SCAN_DOWN,
+	[KEYMAP_MAIN][CHKB4_LONG][KEY_05] = ACTION_SWEEP_UP,
+	[KEYMAP_MAIN][CHKB4_LONG][KEY_02] = ACTION_SWEEP_DOWN,
+	[KEYMAP_MAIN][CHKB4_PRESS][KEY_09] = ACTION_FM,
+	[KEYMAP_MAIN][CHKB4_PRESS][KEY_10] = ACTION_MW,
+	[KEYMAP_MAIN][CHKB4_PRESS][KEY_11] = ACTION_SW,
+	[KEYMAP_MAIN][CHKB4_PRESS][KEY_06] = ACTION_OFF,
+	[KEYMAP_MAIN][CHKB4_PRESS][KEY_07] = ACTION_LOG_OPEN,
+	[KEYMAP_MAIN][CHKB4_PRESS][KEY_08] = ACTION_VOLUME_UP,
+	[KEYMAP_MAIN][CHKB4_PRESS][KEY_03] = ACTION_VOLUME_DOWN,
+	[KEYMAP_MAIN][CHKB4_REPEAT][KEY_08] = ACTION_VOLUME_UP,
+	[KEYMAP_MAIN][CHKB4_REPEAT][KEY_03] = ACTION_VOLUME_DOWN,
+	[KEYMAP_MAIN][CHKB4_PRESS][KEY_00] = ACTION_ENTRY_OPEN,
+
+	[KEYMAP_LOG][CHKB4_PRESS][KEY_04] = ACTION_LOG_DOWN,
+	[KEYMAP_LOG][CHKB4_PRESS][KEY_01] = ACTION_LOG_UP,
+	[KEYMAP_LOG][CHKB4_REPEAT][KEY_04] = ACTION_LOG_DOWN,
+	[KEYMAP_LOG][CHKB4_REPEAT][KEY_01] = ACTION_LOG_UP,
+	[KEYMAP_LOG][CHKB4_PRESS][KEY_07] = ACTION_LOG_CLOSE,
+
+	[KEYMAP_ENTRY][CHKB4_PRESS][KEY_00 ... KEY_09] = ACTION_ENTRY_DIGIT,
+	[KEYMAP_ENTRY][CHKB4_PRESS][KEY_10] = ACTION_ENTRY_BACK,
+	[KEYMAP_ENTRY][CHKB4_LONG][KEY_10] = ACTION_ENTRY_CANCEL,
+	[KEYMAP_ENTRY][CHKB4_PRESS][KEY_11] = ACTION_ENTRY_ENTER,
+};
+
+
+
+
+/*
+	EEPROM keymap override, same layout as 'keymap'.
+*/
+
+uint8_t keymap_ee[KEYMAP_LAYERS][CHKB4_EVENT_TYPES][KEYMAP_KEYS] EEMEM = {
+	[0 ... KEYMAP_LAYERS - 1][0 ... CHKB4_EVENT_TYPES - 1][0 ... KEYMAP_KEYS - 1] = KEYMAP_DEFAULT
+};
+
+#endif
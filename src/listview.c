@@ -0,0 +1,104 @@
+/*
+    Scrolling list view for the UC1701 display.
+*/
+
+#include "listview.h"
+
+
+
+
+/*
+    Globals
+*/
+
+uint8_t listview_count;      // number of items.
+uint8_t listview_first;      // index of the item at the top of the screen.
+uint8_t listview_page;       // display memory page shown at the top of the screen.
+uint8_t (*listview_draw_item)(uint8_t line, uint8_t item);
+
+
+
+
+/*
+    Draw an item, or a blank line past the end of the list, into a display memory page.
+*/
+
+void listview_draw(uint8_t page, uint8_t item)
+{
+  uint8_t x = 0;
+
+  if(item < listview_count) x = listview_draw_item(page, item);
+  else uc1701_cursor_move_px(page, 0);
+  for(; x < UC1701_WIDTH; x++) uc1701_print_column(0x00);
+}
+
+
+
+
+/*
+    Open a list.
+*/
+
+void listview_open(uint8_t count, uint8_t (*draw_item)(uint8_t line, uint8_t item))
+{
+  uint8_t line;
+
+  listview_count = count;
+  listview_draw_item = draw_item;
+  listview_first = 0;
+  listview_page = 0;
+  uc1701_set_scroll_line(0);
+  for(line = 0; line < UC1701_LINES; line++) listview_draw(line, line);
+}
+
+
+
+
+/*
+    Scroll the list by one item.
+*/
+
+void listview_scroll(int8_t dir)
+{
+  if(dir > 0)
+  {
+    if(listview_first + UC1701_LINES >= listview_count) return;
+    // the top page goes out of view and becomes the bottom one, showing the next item
+    listview_draw(listview_page, listview_first + UC1701_LINES);
+    listview_first++;
+    listview_page = (listview_page + 1) & (UC1701_LINES - 1);
+  }
+  else
+  {
+    if(listview_first == 0) return;
+    // the bottom page goes out of view and becomes the top one, showing the previous item
+    listview_first--;
+    listview_page = (listview_page - 1) & (UC1701_LINES - 1);
+    listview_draw(listview_page, listview_first);
+  }
+  uc1701_set_scroll_line(listview_page << 3);
+}
+
+
+
+
+/*
+    Top item.
+*/
+
+uint8_t listview_top(void)
+{
+  return listview_first;
+}
+
+
+
+
+/*
+    Close the list.
+*/
+
+void listview_close(void)
+{
+  uc1701_set_scroll_line(0);
+}
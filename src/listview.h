@@ -0,0 +1,70 @@
+/*
+    Scrolling list view for the UC1701 display.
+
+    A full screen list, one item per display line, scrolled by the display's start line
+    register instead of redrawing. Scrolling by one item moves the display window by a line
+    and draws only the newly exposed item, into the memory page that just went out of view.
+
+    A scroll step sends 1 start line command byte and one line of 3 address and 102 data bytes
+    (106 bytes), against 840 bytes for redrawing the 8 lines of the screen.
+
+    Items are drawn by a function supplied by the caller. It is given the display memory page
+    ('line' for 'uc1701_cursor_move()') and the item's index, must move the cursor to the start
+    of the page, print the item and return the pixel column it reached. The rest of the line is
+    cleared by the list view.
+
+    The whole display scrolls, so the list view owns the screen while open.
+    'listview_close()' restores the start line, the caller then redraws the screen.
+*/
+
+#ifndef __LISTVIEW__
+#define __LISTVIEW__
+
+#include <stdint.h>
+#include "uc1701.h"
+
+
+
+
+/*
+    API
+*/
+
+/*
+    Open a list of 'count' items, showing the first UC1701_LINES items.
+*/
+
+void listview_open(uint8_t count, uint8_t (*draw_item)(uint8_t line, uint8_t item));
+
+
+
+
+/*
+    Scroll the list one item down ('dir' > 0) or up ('dir' < 0).
+    Does nothing at the ends of the list.
+*/
+
+void listview_scroll(int8_t dir);
+
+
+
+
+/*
+    Index of the item at the top of the screen.
+*/
+
+uint8_t listview_top(void);
+
+
+
+
+/*
+    Close the list, setting the display's start line back to 0.
+*/
+
+void listview_close(void);
+
+
+
+
+#endif
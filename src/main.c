@@ -14,15 +14,30 @@
 #include <avr/io.h>
 
 //  Needed for retreiving strings stored in program flash memory.
-//#include <avr/pgmspace.h>
+#include <avr/pgmspace.h>
 
 #include <avr/interrupt.h>
-// #include <avr/eeprom.h>
+#include <avr/sleep.h>
+#include <avr/eeprom.h>
 
 #include "delay.h"
 #include "uc1701.h"
 #include "chkb4.h"
+#include "encoder.h"
 #include "si4735.h"
+#include "meter.h"
+#include "icons.h"
+#include "listview.h"
+#include "keymap.h"
+#include "bandplan.h"
+#include "sched.h"
+#include "timer.h"
+#include "rds.h"
+#include "uart.h"
+#include "cat.h"
+#include "telemetry.h"
+#include "history.h"
+#include "occupancy.h"
 
 //___ GLOBALS _______________________________________________________________________________
 
@@ -31,54 +46,383 @@
 #define SW 2
 #define OFF 3
 
+// Receiver function (SI4735_FM / SI4735_AM) of a band.
+#define band_function(band) ((band) == FM ? SI4735_FM : SI4735_AM)
+
 uint8_t band;
 uint16_t freq[3];
 uint8_t step[3];
 uint16_t top_limit[3];
 uint16_t bottom_limit[3];
 uint16_t antcap[3];
+uint8_t volume;
+
+// Band plan entry of every band. Its limits and step are copied into bottom_limit, top_limit and step.
+uint8_t plan[3];
+
+// Volume range of the SI4735_RX_VOLUME property.
+#define VOLUME_MAX 63
+
+/*
+	Listening state saved in the EEPROM: the band playing, every band's band plan entry and channel, and the volume.
+	Saved STATE_SAVE_DELAY after the last change, so that tuning across a band writes once,
+	and only the bytes that changed are written. Erased or invalid EEPROM keeps the defaults.
+	Turning the radio off saves OFF as the band, so that the radio comes back on by itself
+	only after a power loss while it was playing.
+*/
+
+#define STATE_VERSION 2
+#define STATE_SAVE_DELAY SCHED_MS(10000)
+
+struct state
+{
+  uint8_t version;
+  uint8_t band;
+  uint8_t volume;
+  uint8_t plan[3];
+  uint16_t freq[3];
+  uint16_t antcap[3];
+};
+
+struct state state_ee EEMEM;
+struct timer state_timer;
+
+// Timer 0 overflows every 256 * 256 / F_CPU seconds (8.2ms at 8MHz, CHKB4_PERIOD_US and SCHED_TICK_US).
+#define TIMER0_CLOCK 0x04 // 8bit prescaler
+
+// Tasks run by the scheduler, in priority order, and their periods.
+#define TASK_KEYS 0
+#define TASK_TIMERS 1
+#define TASK_ENCODER 2
+#define TASK_TUNE 3
+#define TASK_SCAN 4
+#define TASK_METERS 5
+#define TASK_RDS 6
+#define TASK_STATUS 7
+#define TASK_START 8
+#define TASK_CAT 9
+#define TASKS 10
+
+#define ENCODER_PERIOD SCHED_MS(ENCODER_PERIOD_MS)
+#define METERS_PERIOD SCHED_MS(100)
+#define RDS_PERIOD SCHED_MS(80)
+#define STATUS_PERIOD SCHED_MS(500)
+
+// Signal strength (S-unit scale) and SNR meters.
+struct meter s_meter, snr_meter;
+
+// Signal history: a sample every HISTORY_DIVIDER meter refreshes (a graph HISTORY_SIZE / 2 seconds wide),
+// kept for the channel and band it was taken on.
+#define HISTORY_DIVIDER 5
+uint8_t history_div, history_band;
+uint16_t history_freq;
+
+// Width in pixels of the RDS station name field, left of the stereo icon.
+#define RDS_PS_WIDTH 64
+
+// Timeouts: backlight after the last key or encoder turn, scan, RDS station name after its last group.
+#define BACKLIGHT_TIMEOUT SCHED_MS(10000)
+#define SEEK_TIMEOUT SCHED_MS(30000)
+#define RDS_TIMEOUT SCHED_MS(5000)
+struct timer backlight_timer, seek_timer, rds_timer;
+
+// Parts of a cold start still pending, and the last cold start's latency in ticks, from the band key to audio (tuned).
+#define START_LCD 0x01
+#define START_RADIO 0x02
+uint8_t start_pending;
+uint16_t start_time, start_latency;
+struct timer lcd_timer;
+
+// Scan direction while scanning, 0 otherwise. While sweeping, the channels left to tune and the channel to return to.
+int8_t scan_dir;
+uint16_t scan_sweep, scan_from;
+
+// Key whose press stopped a scan, plus 1, until the next press (0 for none).
+uint8_t scan_stop_key;
+
+// Latency in ticks of the last jump to a station of the occupancy map, from the bit scan to the end of the tune's measure.
+uint16_t jump_latency;
+
+// Log of the stations found by scanning, newest first, shown in a scrolling list view.
+#define SCAN_LOG_SIZE 16
+uint16_t scan_log_freq[SCAN_LOG_SIZE];
+uint8_t scan_log_band[SCAN_LOG_SIZE];
+uint8_t scan_log_head, scan_log_count;
+
+// Keymap layer of the screen taking keys.
+uint8_t keymap_layer;
+
+// Frequency entry: the digits entered so far and their value, cancelled ENTRY_TIMEOUT after the last key.
+#define ENTRY_DIGITS 5
+#define ENTRY_TIMEOUT SCHED_MS(10000)
+uint8_t entry_count;
+uint32_t entry_value;
+struct timer entry_timer;
+
+// CAT events (CAT_STREAM_x) sent to the host.
+uint8_t cat_stream;
+
+// Channels to step, summed up from the tuning events and the encoder and tuned to once.
+int tune_steps;
 
 //___ FUNCTIONS ______________________________________________________________________________
 
 /*
 
-	Measure
+	Display layout
+
+	Draws the static labels of the main screen and resets the meters.
+	The screen is expected to be blank.
 
 */
 
-void measure(void)
+void display_layout(void)
+{
+  uc1701_cursor_move(4, 0);
+  uc1701_print_str_P(PSTR("S"));
+  uc1701_cursor_move(5, 0);
+  uc1701_print_str_P(PSTR("SN"));
+  meter_init(&s_meter, 4, 12, METER_S_WIDTH);
+  meter_init(&snr_meter, 5, 12, METER_S_WIDTH);
+  history_draw();
+}
+
+
+
+
+
+/*
+
+	Meters
+
+	Updates the meters from the last RSQ status.
+	Every HISTORY_DIVIDER refreshes the RSQ status read for the meters is added to the signal history too,
+	drawing one new column of its graph.
+
+*/
+
+void meters_update(void)
+{
+  meter_update(&s_meter, meter_s_length(SI4735_RSSI));
+  meter_update(&snr_meter, SI4735_SNR);
+}
+
+void meters_refresh(void)
 {
   si4735_rsq_status(0);
-  uc1701_cursor_move(0, 6);
+  meters_update();
+  if(++history_div < HISTORY_DIVIDER) return;
+  history_div = 0;
+  history_add(SI4735_RSSI, SI4735_SNR);
+  history_draw_last();
+}
+
+
+
+
+/*
+
+	RDS station name
+
+	Shows the last complete RDS station name, or clears its field when there is none.
+
+*/
+
+void display_rds(void)
+{
+  uint8_t x = uc1701_print_prop_str(2, 0, rds_ps);
+  for(; x < RDS_PS_WIDTH; x++) uc1701_print_column(0x00);
+}
+
+
+
+
+/*
+
+	Status
+
+	Shows the received signal quality and the receiver status, which change without retuning.
+
+*/
+
+void display_status(void)
+{
+  si4735_rsq_status(0);
+  uc1701_cursor_move(0, 11);
   uc1701_print_dec_s8(-(SI4735_FREQOFF));
-  uc1701_cursor_move(1, 0);
+  meters_update();
+  uc1701_cursor_move(4, 13);
   uc1701_print_dec_u8(SI4735_RSSI);      
-  uc1701_cursor_move(1, 4);
+  uc1701_cursor_move(5, 13);
   uc1701_print_dec_u8(SI4735_SNR);
   if(SI4735_FMST)
   {
-    uc1701_print_str(" S");      
+    uc1701_blit_P(icon_stereo, 66, 9, ICON_STEREO_WIDTH, ICON_STEREO_HEIGHT);
+    uc1701_cursor_move(1, 14);
     uc1701_print_dec_u8(SI4735_STBLEND);
   }
   else
   {
-    uc1701_print_str("      ");      
+    uc1701_blit_P(icon_mono, 66, 9, ICON_STEREO_WIDTH, ICON_STEREO_HEIGHT);
+    uc1701_cursor_move(1, 14);
+    uc1701_print_str_P(PSTR("   "));
   }
 
   si4735_agc_status();
-  uc1701_cursor_move(2, 13); 
+  uc1701_cursor_move(3, 13); 
   uc1701_print_dec_u8(SI4735_AM_LNA_GAIN_INDEX);
+}
+
+
+
+
+/*
+
+	CAT events
+
+	Sent from the last TUNE STATUS / RDS STATUS response.
+
+*/
+
+void cat_tuned(void)
+{
+  uint8_t data[4] = { band, SI4735_FREQ & 0xff, SI4735_FREQ >> 8, SI4735_TUNE_VALID };
+  cat_send(CAT_TUNED, data, sizeof(data));
+}
+
+void cat_rds(void)
+{
+  uint8_t data[9], i;
+
+  if(!(cat_stream & CAT_STREAM_RDS)) return;
+  // blocks A - D, big endian in the response, sent little endian.
+  for(i = 0; i < 8; i += 2) { data[i] = si4735_if_buffer[5 + i]; data[i + 1] = si4735_if_buffer[4 + i]; }
+  data[8] = si4735_if_buffer[12];
+  cat_send(CAT_RDS, data, sizeof(data));
+}
+
+
+
+
+/*
+
+	Station map
+
+	Every channel tuned to is marked in its band's occupancy map, as a station when the tune was valid.
+	Once a sweep has tuned to every channel of a sub-band, scanning jumps from station to station
+	of the map, a bit scan and a single tune, instead of tuning channel after channel.
+
+*/
+
+// Number of channels of the band's sub-band.
+uint16_t station_channels(void)
+{
+  return (top_limit[band] - bottom_limit[band]) / step[band] + 1;
+}
+
+void station_mark(void)
+{
+  uint16_t offset = freq[band] - bottom_limit[band];
+
+  if(offset % step[band]) return;
+  occupancy_mark(band, offset / step[band], SI4735_TUNE_VALID);
+}
+
+// Returns the frequency of the next station of the map in direction 'dir', or 0 when the map is incomplete or has none.
+uint16_t station_next(int8_t dir)
+{
+  uint16_t channel;
+
+  if(!occupancy_complete[band]) return 0;
+  channel = occupancy_next(band, (freq[band] - bottom_limit[band]) / step[band], dir, station_channels());
+  if(channel == OCCUPANCY_NONE) return 0;
+  return bottom_limit[band] + channel * step[band];
+}
+
+
+
+
+/*
+
+	Measure
+
+	Shows everything about a newly tuned channel. The signal history starts over when the channel or the band changed.
+
+*/
+
+void measure(void)
+{
+  display_status();
+  rds_reset();
+  timer_cancel(&rds_timer);
+  display_rds();
 
   si4735_tune_status(SI4735_INTACK);
-  uc1701_cursor_move(0, 0);
-  uc1701_print_dec_u16(SI4735_FREQ);
-  uc1701_cursor_move(2, 0);
+  station_mark();
+  if(cat_stream & CAT_STREAM_TUNED) cat_tuned();
+  uc1701_print_big_dec_u16(0, 0, SI4735_FREQ, 2);
+  if(SI4735_FREQ != history_freq || band != history_band)
+  {
+    history_freq = SI4735_FREQ;
+    history_band = band;
+    history_div = 0;
+    history_clear();
+    history_draw();
+  }
+  uc1701_cursor_move(3, 0);
   switch(band)
   {
     case MW :
     case SW : uc1701_print_dec_u16(SI4735_READANTCAPAM); break;
-    case FM : uc1701_print_str("     "); break;
+    case FM : uc1701_print_str_P(PSTR("     ")); break;
   }
+  uc1701_cursor_move(3, 6);
+  uc1701_print_str_P(PSTR("    "));
+  uc1701_cursor_move(3, 6);
+  uc1701_print_str_P(bandplan[plan[band]].name);
+}
+
+
+
+
+/*
+
+	Band plan
+
+	'band_plan_select()' makes band plan entry 'index' the sub-band of band 'b', i.e. copies its limits and step,
+	and clears the band's occupancy map.
+	The channel is kept when within the new limits, moved to the nearest lower channel of the new step,
+	and set to the bottom limit otherwise.
+	'band_plan_next()' moves band 'b' to its next sub-band, wrapping around.
+
+*/
+
+void band_plan_select(uint8_t b, uint8_t index)
+{
+  struct bandplan entry;
+
+  memcpy_P(&entry, &bandplan[index], sizeof(entry));
+  plan[b] = index;
+  bottom_limit[b] = entry.bottom;
+  top_limit[b] = entry.top;
+  step[b] = entry.step;
+  occupancy_clear(b);
+  if(freq[b] < entry.bottom || freq[b] > entry.top) freq[b] = entry.bottom;
+  else freq[b] = entry.bottom + (freq[b] - entry.bottom) / entry.step * entry.step;
+}
+
+void band_plan_next(uint8_t b)
+{
+  uint8_t index = plan[b] + 1;
+
+  if(index >= pgm_read_byte(&bandplan_first[b + 1])) index = pgm_read_byte(&bandplan_first[b]);
+  band_plan_select(b, index);
+}
+
+// SI4735_FM_DEEMPHASIS or SI4735_AM_CHANNEL_FILTER value of the band's sub-band.
+uint8_t band_plan_filter(uint8_t b)
+{
+  return pgm_read_byte(&bandplan[plan[b]].filter);
 }
 
 
@@ -88,15 +432,34 @@ void measure(void)
 
 	Power up FM
 
+	'setup_fm()' sets up and tunes the receiver once powered up, or when switching to another band of the same function.
+	The seek spacing can only be 50, 100 or 200kHz: a band with another step (OIRT's 30kHz) seeks by 100kHz.
+
 */
 
-void power_up_fm(void)
+uint8_t fm_seek_spacing(void)
+{
+  if(step[band] == SI4735_FM_SEEK_STEP_50KHz || step[band] == SI4735_FM_SEEK_STEP_100KHz ||
+     step[band] == SI4735_FM_SEEK_STEP_200KHz) return step[band];
+  return SI4735_FM_SEEK_STEP_100KHz;
+}
+
+void setup_fm(void)
 {
-  si4735_power_up(SI4735_XOSCEN|SI4735_FM, SI4735_ANALOG);
   si4735_set_property(SI4735_FM_SEEK_BAND_BOTTOM, bottom_limit[band]);
   si4735_set_property(SI4735_FM_SEEK_BAND_TOP, top_limit[band]);
-  si4735_set_property(SI4735_FM_DEEMPHASIS, SI4735_EUR_50us);
+  si4735_set_property(SI4735_FM_SEEK_FREQ_SPACING, fm_seek_spacing());
+  si4735_set_property(SI4735_FM_DEEMPHASIS, band_plan_filter(band));
+  si4735_set_property(SI4735_RX_VOLUME, volume);
+  si4735_set_property(SI4735_RDS_CONFIG, SI4735_RDSEN | SI4735_BLETHB_3_5_ERRORS | SI4735_BLETHD_3_5_ERRORS |
+                                         SI4735_BLETHA_UNCORRECTABLE | SI4735_BLETHC_UNCORRECTABLE);
   si4735_tune_freq(freq[band], antcap[band], 0);
+}
+
+void power_up_fm(void)
+{
+  si4735_power_up(SI4735_XOSCEN|SI4735_FM, SI4735_ANALOG);
+  setup_fm();
   measure();
 }
 
@@ -109,19 +472,144 @@ void power_up_fm(void)
 
 */
 
-void power_up_am(void)
+void setup_am(void)
 {
-  si4735_power_up(SI4735_XOSCEN|SI4735_AM, SI4735_ANALOG);
   si4735_set_property(SI4735_AM_SEEK_BAND_BOTTOM, bottom_limit[band]);
   si4735_set_property(SI4735_AM_SEEK_BAND_TOP, top_limit[band]);
-  si4735_set_property(SI4735_AM_CHANNEL_FILTER, SI4735_BW4KHZ);
+  si4735_set_property(SI4735_AM_SEEK_FREQ_SPACING, step[band]);
+  si4735_set_property(SI4735_AM_CHANNEL_FILTER, band_plan_filter(band));
+  si4735_set_property(SI4735_RX_VOLUME, volume);
   si4735_tune_freq(freq[band], antcap[band], 0);
+}
+
+void power_up_am(void)
+{
+  si4735_power_up(SI4735_XOSCEN|SI4735_AM, SI4735_ANALOG);
+  setup_am();
   measure();
 }
 
 
 
 
+/*
+
+	Cold start
+
+	Powers up the LCD and the receiver together from OFF, overlapping their start up times:
+	the receiver's crystal settles (SI4735_XOSC_SETTLE_MS) while the LCD's power settles (UC1701_POWER_UP_MS),
+	and the LCD is set up and cleared before the receiver is ready.
+	The LCD's part runs from a timer, the receiver's from the start task, polling CTS.
+	Whichever finishes last shows the tuned channel.
+
+	From the band key to audio takes about 370mS in FM and 390mS in AM (XOSC settle, a tick polling CTS and the tune,
+	polled for STC), instead of 630mS and 710mS powering up one after the other with fixed tune delays. The measured time is kept in 'start_latency'.
+
+*/
+
+void start_done(uint8_t part)
+{
+  start_pending &= ~part;
+  if(!start_pending) measure();
+}
+
+void start_lcd(void)
+{
+  uc1701_init();
+  display_layout();
+  start_done(START_LCD);
+}
+
+void cold_start(uint8_t new_band)
+{
+  band = new_band;
+  start_pending = START_LCD | START_RADIO;
+  start_time = sched_time();
+  uc1701_power_on();
+  timer_start(&lcd_timer, SCHED_MS(UC1701_POWER_UP_MS), start_lcd);
+  si4735_power_up_start(SI4735_XOSCEN | band_function(band), SI4735_ANALOG);
+  sched_wake(TASK_START, SCHED_MS(SI4735_XOSC_SETTLE_MS));
+}
+
+// The receiver takes no command before the POWER UP one completes.
+void cold_start_cancel(void)
+{
+  if(start_pending & START_RADIO) si4735_wait_cts();
+  start_pending = 0;
+  timer_cancel(&lcd_timer);
+  sched_stop(TASK_START);
+}
+
+// The main screen is showing the radio, i.e. the radio is on, not starting and no other screen is open.
+uint8_t main_screen(void)
+{
+  return band != OFF && !start_pending && keymap_layer == KEYMAP_MAIN;
+}
+
+
+
+
+/*
+
+	Saved state
+
+	'state_changed()' is called on every change of the saved state, and (re)starts the save timer.
+	'state_save()' writes it at once, e.g. when turned off, as the power may be removed then.
+
+*/
+
+void state_save(void)
+{
+  struct state state;
+  uint8_t i;
+
+  timer_cancel(&state_timer);
+  state.version = STATE_VERSION;
+  state.band = band;
+  state.volume = volume;
+  for(i = 0; i < 3; i++)
+  {
+    state.plan[i] = plan[i];
+    state.freq[i] = freq[i];
+    state.antcap[i] = antcap[i];
+  }
+  eeprom_update_block(&state, &state_ee, sizeof(state));
+}
+
+void state_changed(void)
+{
+  timer_start(&state_timer, STATE_SAVE_DELAY, state_save);
+}
+
+// Returns the saved band (OFF when the radio was turned off), or OFF when there is no valid saved state.
+uint8_t state_load(void)
+{
+  struct state state;
+  struct bandplan entry;
+  uint8_t i;
+
+  eeprom_read_block(&state, &state_ee, sizeof(state));
+  if(state.version != STATE_VERSION || state.band > OFF || state.volume > VOLUME_MAX) return OFF;
+  for(i = 0; i < 3; i++)
+  {
+    if(state.plan[i] < pgm_read_byte(&bandplan_first[i]) || state.plan[i] >= pgm_read_byte(&bandplan_first[i + 1])) return OFF;
+    memcpy_P(&entry, &bandplan[state.plan[i]], sizeof(entry));
+    if(state.freq[i] < entry.bottom || state.freq[i] > entry.top) return OFF;
+  }
+
+  volume = state.volume;
+  for(i = 0; i < 3; i++)
+  {
+    freq[i] = state.freq[i];
+    band_plan_select(i, state.plan[i]);
+    antcap[i] = state.antcap[i];
+  }
+  return state.band;
+}
+
+
+
+
 #define UP 1
 #define DOWN -1
 
@@ -129,15 +617,166 @@ void power_up_am(void)
 
 	Step
 
+	Moves 'steps' channels up (positive) or down (negative) and tunes.
+
 */
 
-void channel_step(int dir)
+void channel_step(int steps)
 {
-  freq[band] += (step[band] * dir);
-  if(freq[band] < bottom_limit[band]) freq[band] = top_limit[band];
-  if(freq[band] > top_limit[band]) freq[band] = bottom_limit[band];
+  int32_t f = freq[band] + (int32_t) step[band] * steps;
+  if(f < bottom_limit[band]) f = top_limit[band];
+  if(f > top_limit[band]) f = bottom_limit[band];
+  freq[band] = f;
   si4735_tune_freq(freq[band], antcap[band], 0);
   measure();
+  state_changed();
+}
+
+
+
+
+/*
+
+	Scan log
+
+*/
+
+void scan_log_add(void)
+{
+  scan_log_freq[scan_log_head] = freq[band];
+  scan_log_band[scan_log_head] = band;
+  scan_log_head = (scan_log_head + 1) & (SCAN_LOG_SIZE - 1);
+  if(scan_log_count < SCAN_LOG_SIZE) scan_log_count++;
+}
+
+uint8_t scan_log_draw_item(uint8_t line, uint8_t item)
+{
+  uint8_t entry = (scan_log_head - 1 - item) & (SCAN_LOG_SIZE - 1);
+  uc1701_cursor_move(line, 0);
+  uc1701_print_dec_u8(item + 1);
+  switch(scan_log_band[entry])
+  {
+    case FM : uc1701_print_str_P(PSTR(" FM ")); break;
+    case MW : uc1701_print_str_P(PSTR(" MW ")); break;
+    case SW : uc1701_print_str_P(PSTR(" SW ")); break;
+  }
+  uc1701_print_dec_u16(scan_log_freq[entry]);
+  return 12 * 6;
+}
+
+void scan_log_open(void)
+{
+  keymap_layer = KEYMAP_LOG;
+  listview_open(scan_log_count, scan_log_draw_item);
+}
+
+void scan_log_close(void)
+{
+  keymap_layer = KEYMAP_MAIN;
+  listview_close();
+  uc1701_cls();
+  display_layout();
+  measure();
+}
+
+
+
+
+/*
+
+	Frequency entry
+
+	Takes up to ENTRY_DIGITS digits, in the units shown on the main screen (10kHz in FM, 1kHz in AM),
+	drawn one at a time over the frequency. Enter tunes to the value once, when a sub-band of the
+	current band covers it, moving to that sub-band when the current one does not.
+	Otherwise the digits are cleared for another try.
+
+*/
+
+// Draws (digit < 10) or erases (UC1701_BIG_BLANK) the big digit at entry position 'pos'.
+void entry_draw_digit(uint8_t pos, uint8_t digit)
+{
+  uc1701_print_big_digit(0, pos * 2, digit, 2);
+}
+
+void entry_clear(void)
+{
+  while(entry_count) entry_draw_digit(--entry_count, UC1701_BIG_BLANK);
+  entry_value = 0;
+}
+
+void entry_close(void)
+{
+  timer_cancel(&entry_timer);
+  keymap_layer = KEYMAP_MAIN;
+  measure();
+}
+
+void entry_open(void)
+{
+  keymap_layer = KEYMAP_ENTRY;
+  entry_count = ENTRY_DIGITS;
+  entry_clear();
+  timer_start(&entry_timer, ENTRY_TIMEOUT, entry_close);
+}
+
+void entry_digit(uint8_t digit)
+{
+  timer_start(&entry_timer, ENTRY_TIMEOUT, entry_close);
+  if(entry_count == ENTRY_DIGITS) return;
+  entry_draw_digit(entry_count++, digit);
+  entry_value = entry_value * 10 + digit;
+}
+
+void entry_back(void)
+{
+  timer_start(&entry_timer, ENTRY_TIMEOUT, entry_close);
+  if(!entry_count) return;
+  entry_draw_digit(--entry_count, UC1701_BIG_BLANK);
+  entry_value /= 10;
+}
+
+// Returns the band plan entry of the current band covering 'value', the current one first, or BANDPLAN_ENTRIES if none.
+uint8_t entry_plan(uint32_t value)
+{
+  uint8_t index = plan[band], last = pgm_read_byte(&bandplan_first[band + 1]);
+
+  if(value >= bottom_limit[band] && value <= top_limit[band]) return index;
+  for(index = pgm_read_byte(&bandplan_first[band]); index < last; index++)
+    if(value >= pgm_read_word(&bandplan[index].bottom) && value <= pgm_read_word(&bandplan[index].top)) return index;
+  return BANDPLAN_ENTRIES;
+}
+
+// Tunes to 'value', moving to the sub-band covering it. Returns 0, doing nothing, when none does.
+uint8_t tune_to(uint32_t value)
+{
+  uint8_t index = entry_plan(value);
+
+  if(index == BANDPLAN_ENTRIES) return 0;
+  if(index != plan[band])
+  {
+    band_plan_select(band, index);
+    freq[band] = value;
+    if(band == FM) setup_fm(); else setup_am();
+  }
+  else
+  {
+    freq[band] = value;
+    si4735_tune_freq(freq[band], antcap[band], 0);
+  }
+  measure();
+  state_changed();
+  return 1;
+}
+
+void entry_enter(void)
+{
+  if(!entry_count) { entry_close(); return; }
+  if(entry_plan(entry_value) == BANDPLAN_ENTRIES) { entry_clear(); return; }
+
+  timer_cancel(&entry_timer);
+  keymap_layer = KEYMAP_MAIN;
+  tune_to(entry_value);
 }
 
 
@@ -147,30 +786,570 @@ void channel_step(int dir)
 
 	Scan
 
+	The scan task steps a channel per run, until a valid station is found, a key is pressed,
+	the encoder is turned or SEEK_TIMEOUT passes (e.g. on a band without stations).
+	With the band's occupancy map complete it jumps to the map's next station instead,
+	stepping on only when the map has none.
+
+	A sweep tunes to every channel of the sub-band once, filling the occupancy map, and returns
+	to the channel it started from. It is stopped the same way, but has no timeout.
+	On a sub-band the map can't hold (SW has none), a sweep is a plain scan.
+
+*/
+
+void scan_stop(void)
+{
+  scan_dir = 0;
+  scan_sweep = 0;
+  timer_cancel(&seek_timer);
+  sched_stop(TASK_SCAN);
+}
+
+void scan_start(int8_t dir)
+{
+  scan_dir = dir;
+  scan_sweep = 0;
+  timer_start(&seek_timer, SEEK_TIMEOUT, scan_stop);
+  sched_wake(TASK_SCAN, 0);
+}
+
+void sweep_start(int8_t dir)
+{
+  if(station_channels() > occupancy_size(band)) { scan_start(dir); return; }
+  scan_dir = dir;
+  scan_sweep = station_channels();
+  scan_from = freq[band];
+  timer_cancel(&seek_timer);
+  sched_wake(TASK_SCAN, 0);
+}
+
+void sweep_done(void)
+{
+  if(station_channels() <= occupancy_size(band)) occupancy_complete[band] = 1;
+  scan_stop();
+  if(freq[band] != scan_from) tune_to(scan_from);
+}
+
+
+
+
+/*
+
+	Backlight
+
+	On with every key press or encoder turn, off BACKLIGHT_TIMEOUT after the last one.
+
+*/
+
+void backlight_off(void)
+{
+  uc1701_backlight(0);
+}
+
+void backlight_on(void)
+{
+  if(band == OFF) return;
+  uc1701_backlight(1);
+  timer_start(&backlight_timer, BACKLIGHT_TIMEOUT, backlight_off);
+}
+
+
+
+
+/*
+
+	RDS timeout
+
+	Clears the RDS station name when no name has been received for RDS_TIMEOUT.
+
 */
 
-void scan(int dir)
+void rds_clear(void)
 {
-  do
+  rds_reset();
+  if(band == FM && main_screen()) display_rds();
+}
+
+
+
+
+/*
+
+	Actions
+
+	Run by keymap_dispatch() for the key events mapped to them.
+	Actions on the radio do nothing while it is off or starting.
+
+*/
+
+void action_tune_up(struct chkb4_event *event)
+{
+  if(main_screen()) { tune_steps += chkb4_accel(event); sched_wake(TASK_TUNE, 0); }
+}
+
+void action_tune_down(struct chkb4_event *event)
+{
+  if(main_screen()) { tune_steps -= chkb4_accel(event); sched_wake(TASK_TUNE, 0); }
+}
+
+void action_scan_up(struct chkb4_event *event)
+{
+  if(main_screen()) scan_start(UP);
+}
+
+void action_scan_down(struct chkb4_event *event)
+{
+  if(main_screen()) scan_start(DOWN);
+}
+
+void action_sweep_up(struct chkb4_event *event)
+{
+  if(main_screen()) sweep_start(UP);
+}
+
+void action_sweep_down(struct chkb4_event *event)
+{
+  if(main_screen()) sweep_start(DOWN);
+}
+
+// The receiver is power cycled only when the band's function (FM / AM) changes.
+// Between bands of the same function (MW / SW) only the band's properties are set and the channel is tuned.
+// The key of the band already playing jumps to its next sub-band, the same way.
+void band_select(uint8_t new_band)
+{
+  uint8_t old_band = band;
+
+  if(start_pending) return;
+  if(scan_dir) scan_stop();
+  state_changed();
+  if(band == OFF) { cold_start(new_band); return; }
+  if(band == new_band) band_plan_next(band);
+  band = new_band;
+  if(band_function(band) == band_function(old_band))
   {
-    channel_step(dir);
+    if(band == FM) setup_fm(); else setup_am();
+    measure();
+    return;
   }
-  while(!SI4735_TUNE_VALID && !chkb4_any_key_pressed() );
+  si4735_power_down();
+  if(band == FM) power_up_fm(); else power_up_am();
+}
+
+void action_fm(struct chkb4_event *event)
+{
+  band_select(FM);
+}
+
+void action_mw(struct chkb4_event *event)
+{
+  band_select(MW);
+}
+
+void action_sw(struct chkb4_event *event)
+{
+  band_select(SW);
+}
+
+void radio_off(void)
+{
+  uint8_t playing = band != OFF;
+
+  telemetry_stop();
+  band = OFF;
+  if(playing) state_save();
+  history_band = OFF;
+  cold_start_cancel();
+  timer_cancel(&backlight_timer);
+  si4735_power_down();
+  uc1701_power_down();
+}
+
+void action_off(struct chkb4_event *event)
+{
+  radio_off();
+}
+
+void volume_step(int8_t dir)
+{
+  if(!main_screen()) return;
+  if(dir > 0 && volume < VOLUME_MAX) volume++;
+  if(dir < 0 && volume > 0) volume--;
+  si4735_set_property(SI4735_RX_VOLUME, volume);
+  state_changed();
+}
+
+void action_volume_up(struct chkb4_event *event)
+{
+  volume_step(UP);
+}
+
+void action_volume_down(struct chkb4_event *event)
+{
+  volume_step(DOWN);
+}
+
+void action_entry_open(struct chkb4_event *event)
+{
+  if(main_screen()) entry_open();
+}
+
+void action_entry_digit(struct chkb4_event *event)
+{
+  entry_digit(event->key);
+}
+
+void action_entry_back(struct chkb4_event *event)
+{
+  entry_back();
+}
+
+void action_entry_enter(struct chkb4_event *event)
+{
+  entry_enter();
+}
+
+void action_entry_cancel(struct chkb4_event *event)
+{
+  entry_close();
+}
+
+void action_log_open(struct chkb4_event *event)
+{
+  if(main_screen()) scan_log_open();
+}
+
+void action_log_close(struct chkb4_event *event)
+{
+  scan_log_close();
+}
+
+void action_log_up(struct chkb4_event *event)
+{
+  listview_scroll(-1);
+}
+
+void action_log_down(struct chkb4_event *event)
+{
+  listview_scroll(1);
+}
+
+void (* const action_table[ACTIONS])(struct chkb4_event *event) PROGMEM = {
+  [ACTION_TUNE_UP] = action_tune_up,
+  [ACTION_TUNE_DOWN] = action_tune_down,
+  [ACTION_SCAN_UP] = action_scan_up,
+  [ACTION_SCAN_DOWN] = action_scan_down,
+  [ACTION_FM] = action_fm,
+  [ACTION_MW] = action_mw,
+  [ACTION_SW] = action_sw,
+  [ACTION_OFF] = action_off,
+  [ACTION_LOG_OPEN] = action_log_open,
+  [ACTION_LOG_CLOSE] = action_log_close,
+  [ACTION_LOG_UP] = action_log_up,
+  [ACTION_LOG_DOWN] = action_log_down,
+  [ACTION_VOLUME_UP] = action_volume_up,
+  [ACTION_VOLUME_DOWN] = action_volume_down,
+  [ACTION_ENTRY_OPEN] = action_entry_open,
+  [ACTION_ENTRY_DIGIT] = action_entry_digit,
+  [ACTION_ENTRY_BACK] = action_entry_back,
+  [ACTION_ENTRY_ENTER] = action_entry_enter,
+  [ACTION_ENTRY_CANCEL] = action_entry_cancel,
+  [ACTION_SWEEP_UP] = action_sweep_up,
+  [ACTION_SWEEP_DOWN] = action_sweep_down,
+};
+
+
+
+
+/*
+
+	Key dispatch
+
+	Runs the action mapped to a key event in the current keymap layer.
+	A single index into the keymap, the EEPROM override first, then the default.
+
+*/
+
+void keymap_dispatch(struct chkb4_event *event)
+{
+  uint16_t entry = ((uint16_t)keymap_layer * CHKB4_EVENT_TYPES + event->type) * KEYMAP_KEYS + event->key;
+  uint8_t action;
+  void (*handler)(struct chkb4_event *event);
+
+  action = eeprom_read_byte(&keymap_ee[0][0][0] + entry);
+  if(action == KEYMAP_DEFAULT) action = pgm_read_byte(&keymap[0][0][0] + entry);
+  if(action == ACTION_NONE || action >= ACTIONS) return;
+
+  handler = (void (*)(struct chkb4_event *)) pgm_read_word(&action_table[action]);
+  handler(event);
+}
+
+
+
+
+/*
+
+	CAT commands
+
+	Run the commands received from the host, the same way as the keys' actions.
+	Commands on the radio are refused while it is off or starting, or another screen than the main one is open.
+
+*/
+
+uint8_t cat_execute(struct cat_frame *frame, uint8_t *reply)
+{
+  uint8_t *data = frame->data, length = frame->length, i;
+  uint16_t value;
+
+  reply[0] = CAT_OK;
+  switch(frame->command)
+  {
+    case CAT_PING :
+      if(length > CAT_DATA_MAX - 1) { reply[0] = CAT_ERR_LENGTH; return 1; }
+      for(i = 0; i < length; i++) reply[1 + i] = data[i];
+      return 1 + length;
+
+    case CAT_STREAM :
+      if(length != 1) { reply[0] = CAT_ERR_LENGTH; return 1; }
+      cat_stream = data[0];
+      return 1;
+
+    case CAT_BAND :
+      if(length != 1) { reply[0] = CAT_ERR_LENGTH; return 1; }
+      if(data[0] > CAT_BAND_OFF) { reply[0] = CAT_ERR_VALUE; return 1; }
+      if(start_pending || keymap_layer != KEYMAP_MAIN) { reply[0] = CAT_ERR_OFF; return 1; }
+      if(data[0] == CAT_BAND_OFF) radio_off();
+      else if(data[0] != band) band_select(data[0]);
+      return 1;
+  }
+
+  // the commands below need the receiver powered up.
+  if(band == OFF || start_pending) { reply[0] = CAT_ERR_OFF; return 1; }
+  switch(frame->command)
+  {
+    case CAT_SET_PROPERTY :
+      if(length != 4) { reply[0] = CAT_ERR_LENGTH; return 1; }
+      si4735_set_property(data[0] | data[1] << 8, data[2] | data[3] << 8);
+      return 1;
+
+    case CAT_GET_PROPERTY :
+      if(length != 2) { reply[0] = CAT_ERR_LENGTH; return 1; }
+      si4735_get_property(data[0] | data[1] << 8);
+      value = SI4735_PROPERTY_VALUE;
+      reply[1] = value & 0xff;
+      reply[2] = value >> 8;
+      return 3;
+
+    case CAT_TELEMETRY_RATE :
+      if(length != 2) { reply[0] = CAT_ERR_LENGTH; return 1; }
+      value = data[0] | data[1] << 8;
+      if(!value) telemetry_stop();
+      else if(!(value = telemetry_start(value))) { reply[0] = CAT_ERR_VALUE; return 1; }
+      reply[1] = value & 0xff;
+      reply[2] = value >> 8;
+      reply[3] = SCHED_CLOCK_US;
+      return 4;
+
+    case CAT_RSQ :
+      if(length != 0) { reply[0] = CAT_ERR_LENGTH; return 1; }
+      si4735_rsq_status(0);
+      reply[1] = SI4735_RSSI;
+      reply[2] = SI4735_SNR;
+      reply[3] = SI4735_FREQOFF;
+      reply[4] = SI4735_STBLEND;
+      reply[5] = (SI4735_VALID ? CAT_RSQ_VALID : 0) | (SI4735_FMST ? CAT_RSQ_STEREO : 0);
+      return 6;
+  }
+
+  // the commands below tune, on the main screen.
+  if(keymap_layer != KEYMAP_MAIN) { reply[0] = CAT_ERR_OFF; return 1; }
+  switch(frame->command)
+  {
+    case CAT_TUNE :
+      if(length != 2) { reply[0] = CAT_ERR_LENGTH; return 1; }
+      if(scan_dir) scan_stop();
+      if(!tune_to(data[0] | data[1] << 8)) { reply[0] = CAT_ERR_VALUE; return 1; }
+      reply[1] = freq[band] & 0xff;
+      reply[2] = freq[band] >> 8;
+      return 3;
+
+    case CAT_SEEK :
+      if(length != 1) { reply[0] = CAT_ERR_LENGTH; return 1; }
+      scan_start((int8_t) data[0] < 0 ? DOWN : UP);
+      return 1;
+  }
+
+  reply[0] = CAT_ERR_COMMAND;
+  return 1;
 }
 
 
 
 
+/*
+
+	Tasks
+
+*/
+
+// Takes all pending key events. Tuning steps are summed up and tuned to once by the tune task,
+// so that repeats queued while tuning don't each cost a tune.
+// A key pressed while scanning only stops the scan: its release, SHORT and LONG events are dropped.
+void task_keys(void)
+{
+  struct chkb4_event event;
+
+  while(chkb4_get_event(&event))
+  {
+    if(event.type == CHKB4_PRESS) scan_stop_key = 0;
+    if(scan_dir && event.type == CHKB4_PRESS) { scan_stop(); scan_stop_key = event.key + 1; }
+    else if(event.key + 1 != scan_stop_key) keymap_dispatch(&event);
+    backlight_on();
+  }
+}
+
+// All the detents turned since the last read make a single step,
+// so a fast spin costs one tune per ENCODER_PERIOD instead of one per detent.
+void task_encoder(void)
+{
+  int8_t detents = encoder_read();
+
+  if(!detents) return;
+  backlight_on();
+  if(scan_dir) scan_stop();
+  else if(keymap_layer == KEYMAP_LOG) listview_scroll(detents > 0 ? 1 : -1);
+  else if(main_screen()) { tune_steps += encoder_steps(detents); sched_wake(TASK_TUNE, 0); }
+}
+
+// One-shot, woken by the tuning keys and the encoder.
+void task_tune(void)
+{
+  if(main_screen()) channel_step(tune_steps);
+  tune_steps = 0;
+}
+
+void task_scan(void)
+{
+  uint16_t next, time = sched_time();
+
+  if(!scan_dir || !main_screen()) { scan_stop(); return; }
+  if(scan_sweep)
+  {
+    channel_step(scan_dir);
+    if(--scan_sweep) sched_wake(TASK_SCAN, 0);
+    else sweep_done();
+    return;
+  }
+  next = station_next(scan_dir);
+  if(next) { tune_to(next); jump_latency = sched_time() - time; }
+  else channel_step(scan_dir);
+  if(SI4735_TUNE_VALID) { scan_log_add(); scan_stop(); }
+  else sched_wake(TASK_SCAN, 0);
+}
+
+void task_meters(void)
+{
+  if(main_screen()) meters_refresh();
+}
+
+void task_rds(void)
+{
+  uint8_t status;
+
+  if(band != FM || !main_screen()) return;
+  status = rds_poll();
+  if(status & RDS_PS_GROUP) timer_start(&rds_timer, RDS_TIMEOUT, rds_clear);
+  if(status & RDS_PS_CHANGED) display_rds();
+}
+
+void task_status(void)
+{
+  if(main_screen()) display_status();
+}
+
+// One-shot, woken by a cold start once the receiver's crystal has settled. Waits for CTS a tick at a time.
+void task_start(void)
+{
+  if(!si4735_cts()) { sched_wake(TASK_START, 1); return; }
+  if(band == FM) setup_fm(); else setup_am();
+  start_latency = sched_time() - start_time;
+  start_done(START_RADIO);
+}
+
+// Runs the commands received, replying to each.
+void task_cat(void)
+{
+  struct cat_frame frame;
+  uint8_t reply[CAT_DATA_MAX], length;
+
+  while(cat_poll(&frame))
+  {
+    length = cat_execute(&frame, reply);
+    cat_send(frame.command | CAT_REPLY, reply, length);
+  }
+}
+
+// run, period and deadline (ticks) of every task.
+struct sched_task tasks[TASKS] = {
+  [TASK_KEYS] = { task_keys, 1, 1 },
+  [TASK_TIMERS] = { timer_run, 1, 1 },
+  [TASK_ENCODER] = { task_encoder, ENCODER_PERIOD, 2 },
+  [TASK_TUNE] = { task_tune, 0, 2 },
+  [TASK_SCAN] = { task_scan, 0, 2 },
+  [TASK_METERS] = { task_meters, METERS_PERIOD, METERS_PERIOD / 2 },
+  [TASK_RDS] = { task_rds, RDS_PERIOD, RDS_PERIOD },
+  [TASK_STATUS] = { task_status, STATUS_PERIOD, STATUS_PERIOD / 2 },
+  [TASK_START] = { task_start, 0, 2 },
+  [TASK_CAT] = { task_cat, 1, 2 },
+};
+
+
+
+
 /*
 	timer 0 overflow interrupt
 */
 
 ISR(TIMER0_OVF_vect)
 {
+	sched_tick();
 	chkb4_update();
 }
 
 
+/*
+
+	Idle
+
+	With the radio off and the keyboard and the UART idle, stops the keyboard scanning timer and puts
+	the MCU in power down sleep, until a band key (KEY_09 - KEY_11) or a byte on the UART wakes it up.
+	It then stays awake until the key is debounced, or for the CAT frame following the byte to start.
+
+*/
+
+void idle(void)
+{
+  cli();
+  if(!chkb4_idle() || !uart_idle() || !cat_idle()) { sei(); return; }
+
+  TCCR0B = 0x00; // stop timer 0
+  chkb4_wake_arm();
+  uart_wake_arm();
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  sei();         // the instruction after sei is executed before any interrupt, so no wake up is missed.
+  sleep_cpu();
+  sleep_disable();
+  chkb4_wake_disarm();
+  uart_wake_disarm();
+  cat_wake();     // the pin change may have been a byte on the UART, with a frame to follow
+  encoder_read(); // turning the encoder wakes the MCU too, but does nothing with the radio off
+  TCNT0 = 0;
+  TCCR0B = TIMER0_CLOCK; // restart timer 0
+}
+
+
+
+
 /*
 
 	Init
@@ -179,20 +1358,29 @@ ISR(TIMER0_OVF_vect)
 
 void init(void)
 {
+  uint8_t resume_band, i;
 
-  TCCR0B = 0x05; // start with 10bit prescaler
+  TCCR0B = TIMER0_CLOCK; // start timer 0
   TIMSK0 = 0x01; // enable overflow interrupt
   chkb4_init();
+  encoder_init();
+  uart_init();
+  rds_group_handler = cat_rds;
 
   uc1701_io_init();
   si4735_init();
 
-  bottom_limit[MW] = 522; top_limit[MW] = 1620; step[MW] = 9; antcap[MW] = 0; freq[MW] = bottom_limit[MW];
-  bottom_limit[SW] = 2300; top_limit[SW] = 23000; step[SW] = 5; antcap[SW] = 0; freq[SW] = bottom_limit[SW];
-  bottom_limit[FM] = 8750; top_limit[FM] = 10800; step[FM] = 5; antcap[FM] = 0; freq[FM] = bottom_limit[FM];
+  for(i = 0; i < 3; i++) band_plan_select(i, pgm_read_byte(&bandplan_first[i]));
+  volume = VOLUME_MAX;
 
   band = OFF;
+  history_band = OFF;
   sei();
+  sched_init(tasks, TASKS);
+
+  // Resume the band playing when the power was lost, on its last channel. A radio turned off stays off.
+  resume_band = state_load();
+  if(resume_band != OFF) cold_start(resume_band);
 }
 
 
@@ -244,38 +1432,9 @@ int main(void)
 
   for(;;)
     {
-	if( chkb4_key_pressed( KEY_06 ) ) { band = OFF; si4735_power_down(); uc1701_power_down(); }
-	if( chkb4_key_pressed( KEY_09 ) )
-	  {
-		if( band == OFF ) uc1701_power_up();
-		band = FM;
-	 	si4735_power_down();
-		power_up_fm();
-	  }
-
-	if( chkb4_key_pressed( KEY_10 ) )
-	  {
-		if( band == OFF ) uc1701_power_up();
-		band = MW;
-	 	si4735_power_down();
-		power_up_am();
-	  }
-
-	if( chkb4_key_pressed( KEY_11 ) )
-	  {
-		if( band == OFF ) uc1701_power_up();
-		band = SW;
-	 	si4735_power_down();
-		power_up_am();
-	  }
-
-
-	if( chkb4_key_pressed( KEY_04 ) ) channel_step(UP);
-	if( chkb4_key_pressed( KEY_01 ) ) channel_step(DOWN);
-
-
-	if( chkb4_key_pressed( KEY_05 ) ) scan(UP);
-	if( chkb4_key_pressed( KEY_02 ) ) scan(DOWN);
+	sched_run();
+	if( band != OFF && !start_pending ) telemetry_poll();
+	if( band == OFF ) idle();
     }
 
   return 0;
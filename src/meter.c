@@ -0,0 +1,105 @@
+/*
+    Bar-graph meter widgets for the UC1701 display.
+*/
+
+#include "meter.h"
+
+
+
+
+/*
+    dBuV to S-unit scale bar length.
+*/
+
+const uint8_t meter_s_scale[128] PROGMEM = {
+  13, 14, 15, 15, 16, 17, 17, 18, 19, 19, 20, 21, 21, 22, 23, 23,  //   0 -  15 dBuV
+  24, 25, 25, 26, 27, 27, 28, 29, 29, 30, 31, 31, 32, 33, 33, 34,  //  16 -  31 dBuV
+  35, 35, 36, 36, 37, 37, 38, 38, 38, 39, 39, 40, 40, 40, 41, 41,  //  32 -  47 dBuV
+  42, 42, 42, 43, 43, 44, 44, 44, 45, 45, 46, 46, 46, 47, 47, 48,  //  48 -  63 dBuV
+  48, 48, 49, 49, 50, 50, 50, 51, 51, 52, 52, 52, 53, 53, 54, 54,  //  64 -  79 dBuV
+  54, 55, 55, 56, 56, 56, 57, 57, 58, 58, 58, 59, 59, 60, 60, 60,  //  80 -  95 dBuV
+  60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60,  //  96 - 111 dBuV
+  60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60   // 112 - 127 dBuV
+};
+
+
+
+
+/*
+    Setup a meter.
+*/
+
+void meter_init(struct meter *m, uint8_t line, uint8_t x, uint8_t width)
+{
+  m->line = line;
+  m->x = x;
+  m->width = width;
+  m->length = 0;
+  m->peak = 0;
+  m->hold = 0;
+}
+
+
+
+
+/*
+    Draw the meter's columns 'from' up to (not including) 'to', from the meter's current state.
+*/
+
+void meter_draw(struct meter *m, uint8_t from, uint8_t to)
+{
+  uc1701_cursor_move_px(m->line, m->x + from);
+  for(; from < to; from++)
+  {
+    if(from < m->length) uc1701_print_column(METER_BAR);
+    else if(from + 1 == m->peak) uc1701_print_column(METER_PEAK);
+    else uc1701_print_column(METER_EMPTY);
+  }
+}
+
+
+
+
+/*
+    Update a meter.
+*/
+
+void meter_update(struct meter *m, uint8_t length)
+{
+  uint8_t from, to, old_peak = m->peak;
+
+  if(length > m->width) length = m->width;
+
+  // the bar's columns that changed
+  if(length > m->length) { from = m->length; to = length; }
+  else { from = length; to = m->length; }
+
+  // peak hold and decay
+  if(length >= m->peak) { m->peak = length; m->hold = METER_PEAK_HOLD; }
+  else if(m->hold) m->hold--;
+  else m->peak--;
+
+  m->length = length;
+  if(from < to) meter_draw(m, from, to);
+
+  // A decaying peak marker moves one column to the left.
+  // Redraw its old and new column, unless already drawn with the bar.
+  if(m->peak < old_peak)
+  {
+    uint8_t lo = m->peak ? m->peak - 1 : 0;
+    if(lo < length) lo = length;
+    if(lo < old_peak && (lo < from || old_peak > to)) meter_draw(m, lo, old_peak);
+  }
+}
+
+
+
+
+/*
+    Map dBuV to a bar length on the S-unit scale.
+*/
+
+uint8_t meter_s_length(uint8_t dbuv)
+{
+  return pgm_read_byte_near(meter_s_scale + (dbuv & 0x7f));
+}
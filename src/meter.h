@@ -0,0 +1,95 @@
+/*
+    Bar-graph meter widgets for the UC1701 display.
+
+    A meter is a horizontal bar, one display line (8 pixels) high, with a peak hold marker.
+    The meter remembers the bar length and the peak marker position it has last drawn,
+    so an update only writes the columns that changed since the previous update.
+    A typical update costs the 3 bytes of the address commands plus one byte per changed column,
+    so meters can be refreshed a lot more often than the text fields, for the same bus traffic.
+
+    The peak marker holds for METER_PEAK_HOLD updates and then decays by one pixel per update.
+*/
+
+#ifndef __METER__
+#define __METER__
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "uc1701.h"
+
+
+
+
+/*
+    Setup
+*/
+
+// Number of updates the peak marker holds before decaying.
+#define METER_PEAK_HOLD 10
+
+// Column bitmaps for the bar, the peak marker and the empty part of a meter.
+#define METER_BAR 0x3c
+#define METER_PEAK 0x7e
+#define METER_EMPTY 0x00
+
+// Width in pixels of the meters using the S-unit scale.
+#define METER_S_WIDTH 60
+
+
+
+
+/*
+    Meter state
+*/
+
+struct meter
+{
+  uint8_t line;      // display line.
+  uint8_t x;         // first pixel column.
+  uint8_t width;     // bar width in pixels.
+  uint8_t length;    // bar length currently drawn.
+  uint8_t peak;      // peak marker position currently drawn (the marker occupies column 'peak - 1').
+  uint8_t hold;      // updates left before the peak marker decays.
+};
+
+
+
+
+/*
+    API
+*/
+
+/*
+    Set up a meter at display 'line' and pixel column 'x', 'width' pixels wide.
+    Nothing is drawn, the meter's area is expected to be blank.
+*/
+
+void meter_init(struct meter *m, uint8_t line, uint8_t x, uint8_t width);
+
+
+
+
+/*
+    Set the meter's bar to 'length' pixels (clipped to the meter's width),
+    writing only the columns that changed.
+*/
+
+void meter_update(struct meter *m, uint8_t length);
+
+
+
+
+/*
+    Map a signal strength in dBuV (0 - 127) to a bar length on the S-unit scale.
+
+    The scale is METER_S_WIDTH pixels wide. S1 to S9 take 4 pixels per S-unit (6dB),
+    with S9 (34dBuV) at 36 pixels. Above S9 every 10dB take 4 pixels, up to S9+60dB.
+    The mapping is a single table lookup.
+*/
+
+uint8_t meter_s_length(uint8_t dbuv);
+
+
+
+
+#endif
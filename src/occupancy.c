@@ -0,0 +1,101 @@
+/*
+    Station occupancy map.
+*/
+
+#include "occupancy.h"
+#include <avr/pgmspace.h>
+
+
+
+
+/*
+    Globals
+*/
+
+uint8_t occupancy_complete[OCCUPANCY_BANDS];
+
+// the maps of all bands, one after the other, and where each one starts.
+uint8_t occupancy_map[OCCUPANCY_FM_BYTES + OCCUPANCY_MW_BYTES + OCCUPANCY_SW_BYTES];
+
+const uint8_t occupancy_first[OCCUPANCY_BANDS + 1] PROGMEM = {
+  0,
+  OCCUPANCY_FM_BYTES,
+  OCCUPANCY_FM_BYTES + OCCUPANCY_MW_BYTES,
+  OCCUPANCY_FM_BYTES + OCCUPANCY_MW_BYTES + OCCUPANCY_SW_BYTES
+};
+
+
+
+
+/*
+    Map
+*/
+
+void occupancy_clear(uint8_t band)
+{
+  uint8_t i = pgm_read_byte(&occupancy_first[band]), last = pgm_read_byte(&occupancy_first[band + 1]);
+
+  for(; i < last; i++) occupancy_map[i] = 0x00;
+  occupancy_complete[band] = 0;
+}
+
+uint16_t occupancy_size(uint8_t band)
+{
+  return (pgm_read_byte(&occupancy_first[band + 1]) - pgm_read_byte(&occupancy_first[band])) * 8;
+}
+
+void occupancy_mark(uint8_t band, uint16_t channel, uint8_t occupied)
+{
+  uint8_t *byte = occupancy_map + pgm_read_byte(&occupancy_first[band]) + (channel >> 3), bit = 1 << (channel & 0x07);
+
+  if(channel >= occupancy_size(band)) return;
+  if(occupied) *byte |= bit; else *byte &= ~bit;
+}
+
+
+
+
+/*
+    Search
+*/
+
+uint16_t occupancy_next(uint8_t band, uint16_t channel, int8_t dir, uint16_t channels)
+{
+  const uint8_t *map = occupancy_map + pgm_read_byte(&occupancy_first[band]);
+  uint16_t left, skip;
+  uint8_t bits;
+
+  if(channels > occupancy_size(band)) channels = occupancy_size(band);
+  if(!channels) return OCCUPANCY_NONE;
+  if(channel >= channels) channel = channels - 1;
+
+  // every channel once, 'channel' last.
+  for(left = channels; left; )
+  {
+    if(dir > 0)
+    {
+      channel = (channel + 1 == channels) ? 0 : channel + 1;
+      left--;
+      bits = map[channel >> 3] >> (channel & 0x07);
+      if(bits & 0x01) return channel;
+      if(bits) continue;
+      // the rest of the byte is clear.
+      skip = 7 - (channel & 0x07);
+      if(skip > channels - 1 - channel) skip = channels - 1 - channel;
+    }
+    else
+    {
+      channel = channel ? channel - 1 : channels - 1;
+      left--;
+      bits = map[channel >> 3] << (7 - (channel & 0x07));
+      if(bits & 0x80) return channel;
+      if(bits) continue;
+      // the byte is clear below.
+      skip = channel & 0x07;
+    }
+    if(skip > left) skip = left;
+    channel += dir > 0 ? skip : -skip;
+    left -= skip;
+  }
+  return OCCUPANCY_NONE;
+}
@@ -0,0 +1,94 @@
+/*
+    Station occupancy map: a bit per channel of every band, set when the channel last tuned to was a valid station.
+
+    A band's channels are numbered from its sub-band's bottom limit up, one per step, so a map only holds
+    for the sub-band it was filled on and is cleared when the sub-band changes. Every band has a fixed size
+    map, enough for its largest sub-band (FM: 416 channels, 87.5 - 108MHz at 50kHz; MW: 128 channels).
+    SW has none: its whole range (4761 channels) doesn't fit, and a map of its meter bands isn't worth
+    the RAM, so its map holds no channel and is never complete.
+
+    'occupancy_complete' tells whether every channel of a band's map has been tuned to since the map
+    was cleared, i.e. whether a channel not set is known to be empty.
+*/
+
+#ifndef __OCCUPANCY__
+#define __OCCUPANCY__
+
+#include <stdint.h>
+
+
+
+
+/*
+    Setup
+*/
+
+// Map sizes in bytes, in the order of the bands (FM, MW, SW).
+#define OCCUPANCY_FM_BYTES 52
+#define OCCUPANCY_MW_BYTES 16
+#define OCCUPANCY_SW_BYTES 0
+
+#define OCCUPANCY_BANDS 3
+
+// Returned by 'occupancy_next()' when no channel is set.
+#define OCCUPANCY_NONE 0xffff
+
+
+
+
+/*
+    Globals
+*/
+
+// Non zero when the band's map is complete.
+extern uint8_t occupancy_complete[OCCUPANCY_BANDS];
+
+
+
+
+/*
+    API
+*/
+
+/*
+    Clear the map of 'band', making it incomplete.
+*/
+
+void occupancy_clear(uint8_t band);
+
+
+
+
+/*
+    Number of channels the map of 'band' holds.
+*/
+
+uint16_t occupancy_size(uint8_t band);
+
+
+
+
+/*
+    Set (occupied non zero) or clear 'channel' of the map of 'band'. Channels outside the map are ignored.
+*/
+
+void occupancy_mark(uint8_t band, uint16_t channel, uint8_t occupied);
+
+
+
+
+/*
+    Find the next channel set, from 'channel' in direction 'dir' (1 up, -1 down),
+    wrapping around at the band's first 'channels' channels (at most 'occupancy_size(band)').
+    'channel' itself is only checked last, after wrapping around. Returns OCCUPANCY_NONE when no channel is set.
+
+    All clear bytes are skipped whole, so a search costs at most about 'channels' / 8 byte reads
+    plus the bits of the bytes at its ends.
+*/
+
+uint16_t occupancy_next(uint8_t band, uint16_t channel, int8_t dir, uint16_t channels);
+
+
+
+
+#endif
@@ -0,0 +1,81 @@
+/*
+    RDS Program Service name decoder.
+*/
+
+#include "rds.h"
+
+
+
+
+/*
+    Globals
+*/
+
+char rds_ps[RDS_PS_LENGTH + 1];
+void (*rds_group_handler)(void);
+
+char rds_ps_next[RDS_PS_LENGTH];   // name being received.
+uint8_t rds_ps_segments;           // segments of 'rds_ps_next' received, one bit each.
+
+// uncorrectable errors value of the SI4735_BLEx block error indicators.
+#define RDS_BLE_UNCORRECTABLE 3
+
+
+
+
+/*
+    Reset
+*/
+
+void rds_reset(void)
+{
+  rds_ps[0] = '\0';
+  rds_ps_segments = 0;
+}
+
+
+
+
+/*
+    Poll
+*/
+
+uint8_t rds_poll(void)
+{
+  uint8_t groups = RDS_POLL_GROUPS, status = 0, segment, i;
+  uint16_t block_b, block_d;
+  char c;
+
+  while(groups--)
+  {
+    si4735_fm_rds_status(SI4735_INTACK);
+    if(!SI4735_RDSFIFOUSED) break;
+    if(rds_group_handler) rds_group_handler();
+    if(SI4735_BLEB == RDS_BLE_UNCORRECTABLE || SI4735_BLED == RDS_BLE_UNCORRECTABLE) continue;
+
+    block_b = SI4735_RDSBLOCKB;
+    if((block_b >> 12) != 0) continue;   // not a group 0A / 0B
+
+    block_d = SI4735_RDSBLOCKD;
+    segment = block_b & 0x03;
+    c = block_d >> 8;
+    rds_ps_next[segment * 2] = (c < ' ' || c > '~') ? ' ' : c;
+    c = block_d & 0xff;
+    rds_ps_next[segment * 2 + 1] = (c < ' ' || c > '~') ? ' ' : c;
+    rds_ps_segments |= 1 << segment;
+    status |= RDS_PS_GROUP;
+
+    if(rds_ps_segments == 0x0f)
+    {
+      rds_ps_segments = 0;
+      for(i = 0; i < RDS_PS_LENGTH; i++)
+      {
+        if(rds_ps[i] != rds_ps_next[i]) status |= RDS_PS_CHANGED;
+        rds_ps[i] = rds_ps_next[i];
+      }
+      rds_ps[RDS_PS_LENGTH] = '\0';
+    }
+  }
+
+  return status;
+}
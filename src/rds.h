@@ -0,0 +1,76 @@
+/*
+    RDS Program Service name decoder.
+
+    Polls the Si4735 RDS FIFO and decodes the 8 character Program Service (PS) name
+    from groups 0A and 0B. Every such group carries 2 characters in block D, at the
+    segment (0 - 3) given by the 2 low bits of block B. Groups with uncorrectable
+    errors in block B or D are dropped.
+
+    A name is taken once all its 4 segments have been received after a reset,
+    so that a station's name is not shown mixed with the previous station's one.
+    Unprintable characters are shown as spaces.
+
+    RDS processing has to be enabled in FM mode, with the SI4735_RDS_CONFIG property.
+*/
+
+#ifndef __RDS__
+#define __RDS__
+
+#include <stdint.h>
+#include "si4735.h"
+
+
+
+
+/*
+    Setup
+*/
+
+// Most groups read from the FIFO per poll.
+#define RDS_POLL_GROUPS 4
+
+#define RDS_PS_LENGTH 8
+
+
+
+
+/*
+    Globals
+*/
+
+// The last complete PS name, empty after a reset.
+extern char rds_ps[RDS_PS_LENGTH + 1];
+
+// Called by 'rds_poll()' for every group read, errors included, with the group in 'si4735_if_buffer'. 0 for none.
+extern void (*rds_group_handler)(void);
+
+
+
+
+/*
+    API
+*/
+
+/*
+    Forget the PS name, e.g. after tuning to another station.
+*/
+
+void rds_reset(void);
+
+
+
+
+/*
+    Read the groups waiting in the FIFO. Returns RDS_PS_GROUP when a group carrying a part of the name
+    was read, and RDS_PS_CHANGED when 'rds_ps' has changed.
+*/
+
+#define RDS_PS_GROUP 0x01
+#define RDS_PS_CHANGED 0x02
+
+uint8_t rds_poll(void);
+
+
+
+
+#endif
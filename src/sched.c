@@ -0,0 +1,135 @@
+/*
+    Cooperative task scheduler.
+*/
+
+#include "sched.h"
+#include <avr/interrupt.h>
+
+
+
+
+/*
+    Globals
+*/
+
+volatile uint16_t sched_ticks;
+
+struct sched_task *sched_tasks;
+uint8_t sched_count;
+
+
+
+
+/*
+    Init
+*/
+
+void sched_init(struct sched_task *tasks, uint8_t count)
+{
+  uint8_t i;
+
+  sched_tasks = tasks;
+  sched_count = count;
+  for(i = 0; i < count; i++)
+  {
+    tasks[i].due = sched_time();
+    tasks[i].ready = tasks[i].period != 0;
+  }
+}
+
+
+
+
+/*
+    Tick
+*/
+
+void sched_tick(void)
+{
+  sched_ticks++;
+}
+
+
+
+
+/*
+    Time
+*/
+
+uint16_t sched_time(void)
+{
+  uint16_t time;
+  uint8_t sreg = SREG;
+
+  cli();
+  time = sched_ticks;
+  SREG = sreg;
+  return time;
+}
+
+uint16_t sched_clock(void)
+{
+  uint8_t ticks, count;
+  uint8_t sreg = SREG;
+
+  cli();
+  ticks = sched_ticks;
+  count = SCHED_TCNT;
+  // the timer has overflowed but its interrupt is still pending: the tick is not counted yet.
+  if((SCHED_TIFR & (1 << SCHED_TOV)) && count < 128) ticks++;
+  SREG = sreg;
+  return ((uint16_t)ticks << 8) | count;
+}
+
+
+
+
+/*
+    Run the due tasks
+*/
+
+void sched_run(void)
+{
+  struct sched_task *task;
+  uint16_t now, late, start, elapsed;
+
+  for(task = sched_tasks; task < sched_tasks + sched_count; task++)
+  {
+    now = sched_time();
+    if(!task->ready || (int16_t)(now - task->due) < 0) continue;
+
+    late = now - task->due;
+    if(late > task->late_max) task->late_max = late;
+    if(late > task->deadline && task->misses < 255) task->misses++;
+
+    if(task->period)
+    {
+      task->due += task->period;
+      if((int16_t)(now - task->due) >= 0) task->due = now + task->period;
+    }
+    else task->ready = 0;
+
+    start = sched_clock();
+    task->run();
+    elapsed = sched_clock() - start;
+    if(elapsed > task->run_max) task->run_max = elapsed;
+  }
+}
+
+
+
+
+/*
+    Wake and stop
+*/
+
+void sched_wake(uint8_t task, uint16_t delay)
+{
+  sched_tasks[task].due = sched_time() + delay;
+  sched_tasks[task].ready = 1;
+}
+
+void sched_stop(uint8_t task)
+{
+  sched_tasks[task].ready = 0;
+}
@@ -0,0 +1,126 @@
+/*
+    Cooperative task scheduler.
+
+    Tasks are functions run from the main loop by 'sched_run()', each to completion.
+    A task never blocks: work that takes long has to be split into steps run on successive calls.
+    The tasks are given in a table, which is also their priority order: when several tasks
+    are due, they run in table order.
+
+    Time is counted in ticks of the timer calling 'sched_tick()' from its interrupt.
+    A periodic task runs every 'period' ticks. A one-shot task ('period' 0) runs once,
+    'delay' ticks after a 'sched_wake()' call. A periodic task can also be woken early with 'sched_wake()'.
+
+    The scheduler keeps statistics for every task:
+    - 'late_max', the worst-case latency, i.e. the most ticks a run started after it was due.
+    - 'misses', the runs started more than 'deadline' ticks late.
+    - 'run_max', the longest run, in timer counts (SCHED_CLOCK_US each), read from the tick timer's counter.
+    A periodic task that falls behind skips the runs it missed instead of running them back to back.
+*/
+
+#ifndef __SCHED__
+#define __SCHED__
+
+#include <stdint.h>
+#include <avr/io.h>
+#include "delay.h"
+
+
+
+
+/*
+    Setup
+*/
+
+// Tick period in microseconds (timer 0 overflow with the 1/256 prescaler), and the count of ticks in 'ms' milliseconds.
+#define SCHED_TICK_US (256UL * 256 * 1000000 / F_CPU)
+#define SCHED_MS(ms) ((uint32_t)(ms) * 1000 / SCHED_TICK_US)
+
+// Counter and overflow flag of the timer calling 'sched_tick()', and the period of one count in microseconds.
+#define SCHED_TCNT TCNT0
+#define SCHED_TIFR TIFR0
+#define SCHED_TOV TOV0
+#define SCHED_CLOCK_US (256UL * 1000000 / F_CPU)
+
+
+
+
+/*
+    Task
+*/
+
+struct sched_task
+{
+  void (*run)(void);     // task function.
+  uint16_t period;       // ticks between runs, 0 for a one-shot task.
+  uint16_t deadline;     // ticks a run may start late without counting as a miss.
+  uint16_t due;          // tick the next run is due at.
+  uint8_t ready;         // 1 while the task is scheduled.
+  uint8_t misses;        // runs started later than the deadline (stops at 255).
+  uint16_t late_max;     // worst-case start latency, in ticks.
+  uint16_t run_max;      // longest run, in timer counts.
+};
+
+
+
+
+/*
+    API
+*/
+
+/*
+    Take a table of 'count' tasks. Periodic tasks are scheduled to run at once, one-shot tasks wait for 'sched_wake()'.
+*/
+
+void sched_init(struct sched_task *tasks, uint8_t count);
+
+
+
+
+/*
+    Count a tick. To be called from the timer interrupt.
+*/
+
+void sched_tick(void);
+
+
+
+
+/*
+    Run the tasks that are due, once each. To be called from the main loop.
+*/
+
+void sched_run(void);
+
+
+
+
+/*
+    Schedule task 'task' (its index in the table) to run 'delay' ticks from now.
+    A periodic task then goes on every 'period' ticks from that run.
+*/
+
+void sched_wake(uint8_t task, uint16_t delay);
+
+
+
+
+/*
+    Unschedule task 'task'. Woken again with 'sched_wake()'.
+*/
+
+void sched_stop(uint8_t task);
+
+
+
+
+/*
+    The tick count, and the tick timer's count (ticks * 256 + timer counter) for measuring short times.
+*/
+
+uint16_t sched_time(void);
+uint16_t sched_clock(void);
+
+
+
+
+#endif
@@ -3,6 +3,7 @@
 */
 
 #include "si4735.h"
+#include "si4735_spi.h"
 
 
 
@@ -18,28 +19,6 @@
 
 
 
-/*
-    SCLK
-*/
-
-inline void si4735_sclk_pulse( void )
-{
-	#ifdef SI4735_SCLK_DELAY
-		delay(SI4735_SCLK_DELAY);
-	#endif
-
-	SI4735_SCLKPORT |= SI4735_SCLKBIT;
-
-	#ifdef SI4735_SCLK_DELAY
-		delay(SI4735_SCLK_DELAY);
-	#endif
-
-	SI4735_SCLKPORT &= ~SI4735_SCLKBIT;
-}
-
-
-
-
 /*
     SDIO
 */
@@ -105,36 +84,55 @@ uint8_t si4735_receiver_mode;
 
 /*
     Send a single byte over SPI
+
+    Unrolled, msb first (see si4735_spi.h). The Si4735 samples SDIO at SCLK's rising edge.
 */
 
 void si4735_spi_send_byte( uint8_t byte )
 {
-	int8_t i;
-
-	for( i = 7; i >= 0; i-- )
-	{
-		if( byte & ( 1 << i ) ) si4735_set_sdio();
-		else si4735_clr_sdio();
-		si4735_sclk_pulse();
-	}
+	asm volatile(
+		SI4735_ASM_SEND_BIT( 7 )
+		SI4735_ASM_SEND_BIT( 6 )
+		SI4735_ASM_SEND_BIT( 5 )
+		SI4735_ASM_SEND_BIT( 4 )
+		SI4735_ASM_SEND_BIT( 3 )
+		SI4735_ASM_SEND_BIT( 2 )
+		SI4735_ASM_SEND_BIT( 1 )
+		SI4735_ASM_SEND_BIT( 0 )
+		:
+		: [byte] "r" ( byte ),
+		  [sdio_port] "I" ( _SFR_IO_ADDR( SI4735_SDIOPORT ) ), [sdio_bit] "I" ( si4735_bitnum( SI4735_SDIOBIT ) ),
+		  SI4735_ASM_PORTS
+	);
 }
 
 
 
 /*
     Receive a single byte over SPI
+
+    Unrolled, msb first (see si4735_spi.h). The Si4735 drives the next bit after SCLK's falling edge,
+    sampled SI4735_SDIO_SETTLE cycles later.
 */
 
 uint8_t si4735_spi_receive_byte( void )
 {
 	uint8_t byte = 0;
-	int8_t i;
 
-	for( i = 7; i >= 0; i-- )
-	{
-		if(si4735_in_sdio()) byte |= ( 1 << i );
-		si4735_sclk_pulse();
-	}
+	asm volatile(
+		SI4735_ASM_RECEIVE_BIT( 7 )
+		SI4735_ASM_RECEIVE_BIT( 6 )
+		SI4735_ASM_RECEIVE_BIT( 5 )
+		SI4735_ASM_RECEIVE_BIT( 4 )
+		SI4735_ASM_RECEIVE_BIT( 3 )
+		SI4735_ASM_RECEIVE_BIT( 2 )
+		SI4735_ASM_RECEIVE_BIT( 1 )
+		SI4735_ASM_RECEIVE_BIT( 0 )
+		: [byte] "+d" ( byte )
+		: [sdio_pin] "I" ( _SFR_IO_ADDR( SI4735_SDIOPIN ) ), [sdio_bit] "I" ( si4735_bitnum( SI4735_SDIOBIT ) ),
+		  [settle] "n" ( SI4735_SDIO_SETTLE ),
+		  SI4735_ASM_PORTS
+	);
 
 	return byte;
 }
@@ -234,16 +232,62 @@ void si4735_spi_long_receive( void )
 
 // ___ Commands ___________________________________________________________________________________________________
 
+/*
+	Clear to send
+*/
+
+uint8_t si4735_cts( void )
+{
+	si4735_if_sort_receive();
+	return SI4735_CTS;
+}
+
+void si4735_wait_cts( void )
+{
+	uint16_t polls = SI4735_CTS_TIMEOUT_MS * 1000UL / SI4735_CTS_POLL_US;
+
+	while( !si4735_cts() && --polls ) delay( DELAY_US( SI4735_CTS_POLL_US ) );
+}
+
+
+
+
+/*
+	Seek / tune complete
+*/
+
+void si4735_wait_stc( void )
+{
+	uint16_t polls = SI4735_STC_TIMEOUT_MS * 1000UL / SI4735_STC_POLL_US;
+
+	for( ;; )
+	{
+		si4735_get_int_status();
+		if( SI4735_STCINT || !--polls ) break;
+		delay( DELAY_US( SI4735_STC_POLL_US ) );
+	}
+}
+
+
+
+
 /*
 	Interface command transaction
+
+	Sends the command and waits for it to complete, instead of a fixed worst-case delay.
 */
 
-void si4735_send_command( uint8_t if_buffer_size )
+void si4735_send( uint8_t if_buffer_size )
 {
 	uint8_t i;
 	for( i = if_buffer_size; i < 8; i++ ) si4735_if_buffer[i] = 0x00;
 	si4735_if_send();
-	delay( _300us_ );
+}
+
+void si4735_send_command( uint8_t if_buffer_size )
+{
+	si4735_send( if_buffer_size );
+	si4735_wait_cts();
 }
 
 
@@ -279,7 +323,7 @@ void si4735_send_command( uint8_t if_buffer_size )
 	The power up command can be issued only when the device is in power down mode.
 */
 
-void si4735_power_up( uint8_t setup, uint8_t audio_out )
+void si4735_power_up_start( uint8_t setup, uint8_t audio_out )
 {
 	si4735_receiver_mode = setup & 0x0f;	// make a note of the receiver's status
 	si4735_if_buffer[0] = 0x01;
@@ -287,10 +331,15 @@ void si4735_power_up( uint8_t setup, uint8_t audio_out )
 	// RDS_ONLY is not supported in AM.
 	if( si4735_receiver_mode == SI4735_AM && setup == SI4735_RDS_ONLY ) si4735_if_buffer[2] = SI4735_ANALOG;
 	si4735_if_buffer[2] = audio_out;
-	si4735_send_command(3);
-	delay( _300ms_ );
+	si4735_send(3);
+}
+
+void si4735_power_up( uint8_t setup, uint8_t audio_out )
+{
+	si4735_power_up_start( setup, audio_out );
+	if( setup & SI4735_XOSCEN ) delay( DELAY_MS( SI4735_XOSC_SETTLE_MS ) );
+	si4735_wait_cts();
 	if((setup & 0x0f) == SI4735_QLID) si4735_if_long_receive();
-	else si4735_if_sort_receive();
 }
 
 
@@ -411,7 +460,6 @@ void si4735_tune_freq( uint16_t freq, uint16_t antcap, uint8_t setup )
 					si4735_if_buffer[1] = setup;
 					si4735_if_buffer[4] = antcap & 0x00ff;
 					si4735_send_command(5);
-					delay( _120ms_ );
 					break;
 
 		case SI4735_AM :	si4735_if_buffer[0] = 0x40;
@@ -419,10 +467,11 @@ void si4735_tune_freq( uint16_t freq, uint16_t antcap, uint8_t setup )
 					si4735_if_buffer[4] = antcap >> 8;
 					si4735_if_buffer[5] = antcap & 0x00ff;
 					si4735_send_command(6);
-					delay( _200ms_ );
 					break;
 	}
 
+	si4735_wait_stc();
+
 	si4735_if_sort_receive();
 }
 
@@ -47,14 +47,47 @@
 
 
 /*
-	SCLK half period Delay in uS.
+	SPI timing in nS: SCLK minimum high and low time, and SDIO valid after SCLK's falling edge (tCDV).
 
-	Uncomment the line bellow
-	to insert a delay routine
-	in the 'sclk_pulse()' code.
+	The SPI byte routines are unrolled inline assembly with a known number of cycles per bit (see si4735_spi.h).
+	The SCLK high time is padded with nops up to SI4735_SCLK_HALF_NS at F_CPU, the low time is always longer.
+	A received bit is sampled SI4735_SDIO_VALID_NS plus the pin synchroniser's 1.5 cycles after the falling edge.
+	The Si4735's SCLK is limited to 2.5MHz, i.e. a 400nS period.
+
+	At 8MHz a sent bit takes 9 cycles (889kHz SCLK), SCLK high for 2 cycles (250nS) and low for 7,
+	a received bit 8 cycles (1MHz SCLK), SCLK high for 2 cycles and low for 6, sampling 2 cycles after the fall.
+	At 16MHz and 20MHz the high time is padded to 4 cycles: 11 cycles per sent bit and 10 per received bit,
+	1.82MHz and 2MHz SCLK at 20MHz.
+*/
+
+#define SI4735_SCLK_HALF_NS 200
+#define SI4735_SDIO_VALID_NS 25
+
+
+
+/*
+	Command completion.
+
+	After every command the status byte is polled every SI4735_CTS_POLL_US, until the CTS bit is set,
+	for SI4735_CTS_TIMEOUT_MS at most (e.g. with the chip held in reset).
+
+	With the crystal oscillator enabled, the oscillator needs SI4735_XOSC_SETTLE_MS from POWER UP
+	before tuning, although CTS is set earlier (110mS max).
 */
 
-#define SI4735_SCLK_DELAY _1us_
+#define SI4735_CTS_POLL_US 100
+#define SI4735_CTS_TIMEOUT_MS 500
+#define SI4735_XOSC_SETTLE_MS 300
+
+/*
+	Tune completion.
+
+	After a tune the STCINT bit is polled with GET INT STATUS every SI4735_STC_POLL_US,
+	for SI4735_STC_TIMEOUT_MS at most, instead of waiting a fixed worst-case time.
+*/
+
+#define SI4735_STC_POLL_US 1000
+#define SI4735_STC_TIMEOUT_MS 250
 
 
 
@@ -86,6 +119,33 @@ void si4735_io_init( void );
 
 
 
+/*
+	CLEAR TO SEND
+
+	'si4735_cts()' reads the status byte and returns non zero when the last command has completed.
+	'si4735_wait_cts()' polls it until then, or for SI4735_CTS_TIMEOUT_MS.
+*/
+
+uint8_t si4735_cts( void );
+void si4735_wait_cts( void );
+
+
+
+
+
+/*
+	SEEK / TUNE COMPLETE
+
+	Polls the STCINT bit until the running tune completes, or for SI4735_STC_TIMEOUT_MS.
+	The bit stays set until cleared with 'si4735_tune_status( SI4735_INTACK )'.
+*/
+
+void si4735_wait_stc( void );
+
+
+
+
+
 /*
 	POWER UP
 
@@ -136,6 +196,14 @@ void si4735_io_init( void );
 
 void si4735_power_up( uint8_t setup, uint8_t audio_out );
 
+/*
+	Only send the POWER UP command, without waiting for it to complete, so that the caller can
+	do other work while the chip boots. Then 'si4735_cts()' tells when it is done.
+	The crystal oscillator still needs SI4735_XOSC_SETTLE_MS before tuning.
+*/
+
+void si4735_power_up_start( uint8_t setup, uint8_t audio_out );
+
 
 
 
@@ -0,0 +1,86 @@
+/*
+	SI4735 SPI bit timing
+
+	The assembly of the unrolled SPI byte routines, in si4735.c, one bit at a time.
+	Kept apart so that tools/test can replay it cycle by cycle against a model of the Si4735.
+
+	Every bit takes a fixed number of cycles, set at compile time from F_CPU:
+	- SCLK is high for 2 + SI4735_SCLK_PAD cycles, at least SI4735_SCLK_HALF_NS.
+	- A sent bit sets SDIO in 5 cycles, before SCLK's rising edge, where the Si4735 samples it.
+	- A received bit waits SI4735_SDIO_SETTLE cycles after SCLK's falling edge before sampling SDIO.
+	  The Si4735 drives the next bit up to SI4735_SDIO_VALID_NS after the falling edge, and the pin's
+	  input synchroniser delays what the 'sbic' reads by up to 1.5 cycles more.
+*/
+
+#ifndef __SI4735_SPI__
+#define __SI4735_SPI__
+
+#include "delay.h"
+
+
+
+
+// bit number of a port bit mask, for the 'sbi', 'cbi', 'sbic' and 'sbrc' instructions.
+#define si4735_bitnum( mask ) ( (mask) & 0x01 ? 0 : (mask) & 0x02 ? 1 : (mask) & 0x04 ? 2 : (mask) & 0x08 ? 3 : \
+				(mask) & 0x10 ? 4 : (mask) & 0x20 ? 5 : (mask) & 0x40 ? 6 : 7 )
+
+// nops padding the SCLK high time (the 'cbi' ending it takes 2 cycles).
+#define SI4735_SCLK_PAD ( DELAY_CYCLES_NS( SI4735_SCLK_HALF_NS ) > 2 ? DELAY_CYCLES_NS( SI4735_SCLK_HALF_NS ) - 2 : 0 )
+
+// nops between SCLK's falling edge and the SDIO sample: SI4735_SDIO_VALID_NS plus 1.5 cycles, rounded up.
+#define SI4735_SDIO_SETTLE ( ( DELAY_CYCLES_NS( 2 * SI4735_SDIO_VALID_NS ) + 4 ) / 2 )
+
+
+
+
+/*
+    SCLK pulse, high for 2 + SI4735_SCLK_PAD cycles.
+*/
+
+#define SI4735_ASM_SCLK_PULSE \
+	"sbi %[sclk_port], %[sclk_bit]"	"\n\t" \
+	".rept %[pad]"			"\n\t" \
+	"nop"				"\n\t" \
+	".endr"				"\n\t" \
+	"cbi %[sclk_port], %[sclk_bit]"	"\n\t"
+
+#define SI4735_ASM_PORTS \
+	[sclk_port] "I" ( _SFR_IO_ADDR( SI4735_SCLKPORT ) ), [sclk_bit] "I" ( si4735_bitnum( SI4735_SCLKBIT ) ), \
+	[pad] "n" ( SI4735_SCLK_PAD )
+
+
+
+
+/*
+    Send bit 'n' of 'byte'
+
+    Sets SDIO with a pair of skip instructions, which take 5 cycles whatever the bit's value,
+    then pulses SCLK.
+*/
+
+#define SI4735_ASM_SEND_BIT( n ) \
+	"sbrc %[byte], " #n		"\n\t" \
+	"sbi %[sdio_port], %[sdio_bit]"	"\n\t" \
+	"sbrs %[byte], " #n		"\n\t" \
+	"cbi %[sdio_port], %[sdio_bit]"	"\n\t" \
+	SI4735_ASM_SCLK_PULSE
+
+
+
+
+/*
+    Receive bit 'n' into 'byte' (cleared beforehand)
+
+    Waits for SDIO to settle, samples it with a skip instruction and an 'ori',
+    which take 2 cycles whatever the bit's value, then pulses SCLK.
+*/
+
+#define SI4735_ASM_RECEIVE_BIT( n ) \
+	".rept %[settle]"		"\n\t" \
+	"nop"				"\n\t" \
+	".endr"				"\n\t" \
+	"sbic %[sdio_pin], %[sdio_bit]"	"\n\t" \
+	"ori %[byte], 1 << " #n		"\n\t" \
+	SI4735_ASM_SCLK_PULSE
+
+#endif
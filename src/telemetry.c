@@ -0,0 +1,119 @@
+/*
+    RSQ telemetry.
+*/
+
+#include "telemetry.h"
+#include <avr/interrupt.h>
+#include "si4735.h"
+#include "sched.h"
+
+
+
+
+/*
+    Globals
+*/
+
+uint8_t telemetry_missed;
+
+// samples due, counted by the timer interrupt.
+volatile uint8_t telemetry_due;
+
+// the frame being filled: sequence number and time of its first sample, then the samples.
+uint8_t telemetry_frame[3 + TELEMETRY_SAMPLES * 4];
+uint8_t telemetry_count, telemetry_seq;
+
+
+
+
+/*
+    Start / stop
+*/
+
+uint16_t telemetry_start(uint16_t rate)
+{
+  uint16_t counts;
+
+  if(rate < TELEMETRY_RATE_MIN || rate > TELEMETRY_RATE_MAX) return 0;
+  counts = (F_CPU / 1024 + rate / 2) / rate;
+
+  TCCR2B = 0x00;
+  telemetry_count = 0;
+  telemetry_due = 0;
+  TCNT2 = 0;
+  OCR2A = counts - 1;
+  TCCR2A = 1 << WGM21;                                 // CTC, top OCR2A
+  TIFR2 = 1 << OCF2A;
+  TIMSK2 = 1 << OCIE2A;
+  TCCR2B = (1 << CS22) | (1 << CS21) | (1 << CS20);    // 1/1024 prescaler
+  return counts * TELEMETRY_COUNT_US;
+}
+
+void telemetry_send(void)
+{
+  if(telemetry_count) cat_send(CAT_TELEMETRY, telemetry_frame, 3 + telemetry_count * 4);
+  telemetry_count = 0;
+}
+
+void telemetry_stop(void)
+{
+  TCCR2B = 0x00;
+  TIMSK2 = 0x00;
+  telemetry_send();
+}
+
+
+
+
+/*
+    Poll
+*/
+
+void telemetry_poll(void)
+{
+  uint8_t due, *sample;
+  uint16_t time;
+
+  cli();
+  due = telemetry_due;
+  telemetry_due = 0;
+  sei();
+  if(!due) return;
+
+  // samples missed: the frame ends, the sequence number skips them.
+  if(due > 1)
+  {
+    telemetry_send();
+    telemetry_seq += due - 1;
+    telemetry_missed = (telemetry_missed + due - 1 < 255) ? telemetry_missed + due - 1 : 255;
+  }
+
+  time = sched_clock();
+  si4735_rsq_status(0);
+
+  if(!telemetry_count)
+  {
+    telemetry_frame[0] = telemetry_seq;
+    telemetry_frame[1] = time & 0xff;
+    telemetry_frame[2] = time >> 8;
+  }
+  sample = telemetry_frame + 3 + telemetry_count * 4;
+  sample[0] = SI4735_RSSI;
+  sample[1] = SI4735_SNR;
+  sample[2] = SI4735_MULT;
+  sample[3] = SI4735_FREQOFF;
+  telemetry_seq++;
+  if(++telemetry_count == TELEMETRY_SAMPLES) telemetry_send();
+}
+
+
+
+
+/*
+    Timer 2 compare interrupt
+*/
+
+ISR(TIMER2_COMPA_vect)
+{
+  if(telemetry_due != 255) telemetry_due++;
+}
@@ -0,0 +1,82 @@
+/*
+    RSQ telemetry: signal quality samples at a fixed rate, streamed to the host as CAT_TELEMETRY events.
+
+    Timer 2 (CTC mode, 1/1024 prescaler) sets the sample rate, its interrupt only counting the samples due.
+    'telemetry_poll()', called from the main loop between tasks, reads RSQ STATUS once a sample is due,
+    so that the rate is not limited to the scheduler's tick. A sample is taken late by at most the
+    longest task run. When a task runs longer than a sample period the samples missed are skipped,
+    counted in 'telemetry_missed', and show as a gap in the sequence numbers.
+
+    Samples are packed TELEMETRY_SAMPLES to a frame (see cat.h for the format). A frame holds consecutive
+    samples only, so it is sent early when a sample was missed. Frames not fitting in the UART's transmit
+    buffer are dropped whole, counted in 'cat_drops'.
+*/
+
+#ifndef __TELEMETRY__
+#define __TELEMETRY__
+
+#include <stdint.h>
+#include <avr/io.h>
+#include "delay.h"
+#include "cat.h"
+
+
+
+
+/*
+    Setup
+*/
+
+// Timer 2 count period in microseconds, and the sample rates it can make.
+#define TELEMETRY_COUNT_US (1024UL * 1000000 / F_CPU)
+#define TELEMETRY_RATE_MIN (F_CPU / 1024 / 256 + 1)
+#define TELEMETRY_RATE_MAX (F_CPU / 1024 / 2)
+
+#define TELEMETRY_SAMPLES ((CAT_DATA_MAX - 3) / 4)
+
+
+
+
+/*
+    Globals
+*/
+
+// Samples skipped because they were taken too late (stops at 255).
+extern uint8_t telemetry_missed;
+
+
+
+
+/*
+    API
+*/
+
+/*
+    Start sampling at 'rate' Hz (TELEMETRY_RATE_MIN - TELEMETRY_RATE_MAX).
+    Returns the actual sample period in microseconds, or 0 (not started) for a rate out of range.
+*/
+
+uint16_t telemetry_start(uint16_t rate);
+
+
+
+
+/*
+    Stop sampling, sending the samples taken so far.
+*/
+
+void telemetry_stop(void);
+
+
+
+
+/*
+    Take the sample due, if any. To be called from the main loop, with the receiver powered up.
+*/
+
+void telemetry_poll(void);
+
+
+
+
+#endif
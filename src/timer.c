@@ -0,0 +1,86 @@
+/*
+    Software timers on a hashed timer wheel.
+*/
+
+#include "timer.h"
+
+
+
+
+/*
+    Globals
+*/
+
+struct timer *timer_wheel[TIMER_SLOTS];
+
+// the last tick processed by timer_run().
+uint16_t timer_now;
+
+
+
+
+/*
+    Start and cancel
+*/
+
+void timer_cancel(struct timer *timer)
+{
+  if(!timer->pprev) return;
+  *timer->pprev = timer->next;
+  if(timer->next) timer->next->pprev = timer->pprev;
+  timer->pprev = 0;
+}
+
+void timer_start(struct timer *timer, uint16_t delay, void (*run)(void))
+{
+  struct timer **slot;
+
+  timer_cancel(timer);
+  if(delay == 0) delay = 1;
+  if(delay > TIMER_MAX_DELAY) delay = TIMER_MAX_DELAY;
+
+  // the expiry is always ahead of timer_now, which never passes sched_time().
+  timer->expires = sched_time() + delay;
+  timer->run = run;
+
+  slot = &timer_wheel[timer->expires & (TIMER_SLOTS - 1)];
+  timer->next = *slot;
+  if(timer->next) timer->next->pprev = &timer->next;
+  *slot = timer;
+  timer->pprev = slot;
+}
+
+uint8_t timer_pending(struct timer *timer)
+{
+  return timer->pprev != 0;
+}
+
+
+
+
+/*
+    Run the expired timers
+*/
+
+void timer_run(void)
+{
+  uint16_t now = sched_time();
+  struct timer *timer;
+
+  while(timer_now != now)
+  {
+    timer_now++;
+    timer = timer_wheel[timer_now & (TIMER_SLOTS - 1)];
+    while(timer)
+    {
+      if(timer->expires == timer_now)
+      {
+        timer_cancel(timer);
+        timer->run();
+        // the function may have changed the list, walk it again.
+        timer = timer_wheel[timer_now & (TIMER_SLOTS - 1)];
+      }
+      else timer = timer->next;
+    }
+  }
+}
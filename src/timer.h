@@ -0,0 +1,95 @@
+/*
+    Software timers on a hashed timer wheel.
+
+    A timer runs a function once, a given number of scheduler ticks after it was started.
+    The timers are kept in a wheel of TIMER_SLOTS lists, a timer expiring at tick 't' in list
+    't % TIMER_SLOTS'. Starting and cancelling a timer link and unlink it from its list in constant
+    time, whatever the number of timers. Each tick only the one list due at that tick is walked,
+    so with the timers spread over the slots a tick looks at about 'timers / TIMER_SLOTS' of them.
+    Timers further than TIMER_SLOTS ticks ahead just stay in their list for more turns of the wheel.
+
+    The timers live in the caller's memory (usually globals), the wheel only links them.
+    The timer interrupt only counts ticks (see sched.h). 'timer_run()' is called from the main loop,
+    catches up with the ticks counted since its last call and runs the expired timers' functions.
+    A timer's function may start or cancel any timer, including its own.
+*/
+
+#ifndef __TIMER__
+#define __TIMER__
+
+#include <stdint.h>
+#include "sched.h"
+
+
+
+
+/*
+    Setup
+*/
+
+// Number of lists in the wheel, a power of 2.
+#define TIMER_SLOTS 16
+
+// Longest delay in ticks.
+#define TIMER_MAX_DELAY 0x7fff
+
+
+
+
+/*
+    Timer
+*/
+
+struct timer
+{
+  struct timer *next;     // next timer in the list.
+  struct timer **pprev;   // the pointer pointing to this timer, 0 while not started.
+  uint16_t expires;       // tick the timer expires at.
+  void (*run)(void);      // function run when the timer expires.
+};
+
+
+
+
+/*
+    API
+*/
+
+/*
+    Start 'timer' to run 'run' 'delay' ticks from now (1 - TIMER_MAX_DELAY).
+    A started timer is restarted.
+*/
+
+void timer_start(struct timer *timer, uint16_t delay, void (*run)(void));
+
+
+
+
+/*
+    Stop 'timer' without running it. Does nothing if it isn't started.
+*/
+
+void timer_cancel(struct timer *timer);
+
+
+
+
+/*
+    Returns 1 while 'timer' is started and hasn't expired.
+*/
+
+uint8_t timer_pending(struct timer *timer);
+
+
+
+
+/*
+    Run the timers expired since the last call. To be called from the main loop.
+*/
+
+void timer_run(void);
+
+
+
+
+#endif
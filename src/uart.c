@@ -0,0 +1,139 @@
+/*
+    Interrupt driven UART (USART0), 8N1.
+*/
+
+#include "uart.h"
+#include <avr/interrupt.h>
+
+
+
+
+/*
+    Globals
+*/
+
+volatile uint8_t uart_overflows;
+
+// receive buffer, written at the head by the receive interrupt, read at the tail by 'uart_read()'.
+volatile uint8_t uart_rx[UART_RX_SIZE];
+volatile uint8_t uart_rx_head, uart_rx_tail;
+
+// transmit buffer, written at the head by 'uart_write()', read at the tail by the data register empty interrupt.
+volatile uint8_t uart_tx[UART_TX_SIZE];
+volatile uint8_t uart_tx_head, uart_tx_tail;
+
+// set once anything has been sent, from then on TXC0 tells whether the line is idle.
+uint8_t uart_sent;
+
+
+
+
+/*
+    Init
+*/
+
+void uart_init(void)
+{
+  UBRR0 = UART_UBRR;
+  UCSR0A = 1 << U2X0;
+  UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+  UCSR0B = (1 << RXCIE0) | (1 << RXEN0) | (1 << TXEN0);
+}
+
+
+
+
+/*
+    Read
+*/
+
+uint8_t uart_read(uint8_t *byte)
+{
+  uint8_t tail = uart_rx_tail;
+
+  if(tail == uart_rx_head) return 0;
+  *byte = uart_rx[tail];
+  uart_rx_tail = (tail + 1) & (UART_RX_SIZE - 1);
+  return 1;
+}
+
+
+
+
+/*
+    Write
+*/
+
+uint8_t uart_write(const uint8_t *data, uint8_t size)
+{
+  uint8_t head = uart_tx_head;
+
+  if(((uart_tx_tail - head - 1) & (UART_TX_SIZE - 1)) < size) return 0;
+  while(size--)
+  {
+    uart_tx[head] = *data++;
+    head = (head + 1) & (UART_TX_SIZE - 1);
+  }
+  uart_tx_head = head;
+  uart_sent = 1;
+  UCSR0B |= 1 << UDRIE0;
+  return 1;
+}
+
+
+
+
+/*
+    Idle
+*/
+
+uint8_t uart_idle(void)
+{
+  if(uart_rx_head != uart_rx_tail || uart_tx_head != uart_tx_tail) return 0;
+  return !uart_sent || (UCSR0A & (1 << TXC0));
+}
+
+
+
+
+/*
+    Wake up
+*/
+
+void uart_wake_arm(void)
+{
+  UART_WAKE_PCMSK |= 1 << UART_WAKE_BIT;
+  PCICR |= 1 << UART_WAKE_PCIE;
+}
+
+void uart_wake_disarm(void)
+{
+  UART_WAKE_PCMSK &= ~(1 << UART_WAKE_BIT);
+}
+
+
+
+
+/*
+    Interrupts
+*/
+
+ISR(USART_RX_vect)
+{
+  uint8_t byte = UDR0, head = uart_rx_head, next = (head + 1) & (UART_RX_SIZE - 1);
+
+  if(next == uart_rx_tail) { if(uart_overflows != 255) uart_overflows++; return; }
+  uart_rx[head] = byte;
+  uart_rx_head = next;
+}
+
+ISR(USART_UDRE_vect)
+{
+  uint8_t tail = uart_tx_tail;
+
+  if(tail == uart_tx_head) { UCSR0B &= ~(1 << UDRIE0); return; }
+  UDR0 = uart_tx[tail];
+  uart_tx_tail = (tail + 1) & (UART_TX_SIZE - 1);
+  // clear the transmit complete flag (written 1), it's set again once this byte has left.
+  UCSR0A = (1 << U2X0) | (1 << TXC0);
+}
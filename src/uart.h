@@ -0,0 +1,107 @@
+/*
+    Interrupt driven UART (USART0), 8N1.
+
+    Received bytes are put into a ring buffer by the receive interrupt, and bytes to send are taken
+    out of another one by the data register empty interrupt, so neither reading nor writing ever waits
+    for the line. Both buffers are single producer / single consumer: the interrupt is the only writer
+    of one index and the main loop the only writer of the other, both single bytes, so neither side
+    has to disable interrupts. Received bytes are dropped when the receive buffer is full,
+    counted in 'uart_overflows'.
+
+    'uart_write()' queues a whole block or nothing, so that a block (e.g. a protocol frame) never goes
+    out cut short when the transmit buffer is full.
+
+    The UART stops in power down sleep. 'uart_wake_arm()' enables the pin change interrupt of RXD,
+    so that a byte arriving wakes the MCU up. That byte is lost, and so are the following ones if
+    the MCU goes back to sleep before they come: the caller has to stay awake for them (see cat.h).
+    The pin change interrupt vector has to be provided elsewhere (PCINT2_vect, the keyboard's).
+*/
+
+#ifndef __UART__
+#define __UART__
+
+#include <stdint.h>
+#include <avr/io.h>
+#include "delay.h"
+
+
+
+
+/*
+    Setup
+*/
+
+#define UART_BAUD 38400
+
+// Baud rate register value in double speed mode (U2X0), rounded to the nearest.
+#define UART_UBRR ((F_CPU + 4UL * UART_BAUD) / (8UL * UART_BAUD) - 1)
+
+// Buffer sizes, powers of 2 up to 128.
+#define UART_RX_SIZE 32
+#define UART_TX_SIZE 64
+
+// RXD pin change interrupt, for waking up.
+#define UART_WAKE_PCMSK PCMSK2
+#define UART_WAKE_PCIE PCIE2
+#define UART_WAKE_BIT PCINT16
+
+
+
+
+/*
+    Globals
+*/
+
+// Received bytes dropped because the receive buffer was full (stops at 255).
+extern volatile uint8_t uart_overflows;
+
+
+
+
+/*
+    API
+*/
+
+void uart_init(void);
+
+
+
+
+/*
+    Take the oldest received byte into 'byte'. Returns 0 when none is waiting.
+*/
+
+uint8_t uart_read(uint8_t *byte);
+
+
+
+
+/*
+    Queue 'size' bytes to send. Returns 0, queuing nothing, when they don't all fit.
+*/
+
+uint8_t uart_write(const uint8_t *data, uint8_t size);
+
+
+
+
+/*
+    Returns non zero when nothing is waiting to be read or sent, and the last byte has left the line.
+*/
+
+uint8_t uart_idle(void);
+
+
+
+
+/*
+    Arm / disarm the wake up on a received byte.
+*/
+
+void uart_wake_arm(void);
+void uart_wake_disarm(void);
+
+
+
+
+#endif
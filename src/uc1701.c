@@ -4,6 +4,10 @@
 
 #include "uc1701.h"
 #include "uc1701_latin_charset.h"
+#include "uc1701_big_digits.h"
+#if defined(UC1701_PRINT_PROP_STR) || defined(UC1701_PRINT_PROP_STR_P)
+#include "uc1701_prop_charset.h"
+#endif
 
 
 
@@ -35,12 +39,12 @@
 
 inline void uc1701_sclk_pulse(void)
 {
-  #ifdef UC1701_SCLK_DELAY
-    delay(UC1701_SCLK_DELAY);
+  #ifdef UC1701_SCLK_DELAY_NS
+    delay_ns(UC1701_SCLK_DELAY_NS);
   #endif
   UC1701_SCLK_PORT &= ~UC1701_SCLK_BIT;
-  #ifdef UC1701_SCLK_DELAY
-    delay(UC1701_SCLK_DELAY);
+  #ifdef UC1701_SCLK_DELAY_NS
+    delay_ns(UC1701_SCLK_DELAY_NS);
   #endif
   UC1701_SCLK_PORT |= UC1701_SCLK_BIT;
 }
@@ -431,6 +435,21 @@ void uc1701_cursor_move(uint8_t line, uint8_t column)
 
 
 
+/*
+    Sets the LCD's data address to display 'line' and pixel column 'x'.
+*/
+
+#ifdef UC1701_CURSOR_MOVE_PX
+void uc1701_cursor_move_px(uint8_t line, uint8_t x)
+{
+  uc1701_set_column_address(x);
+  uc1701_set_page_address(line);
+}
+#endif
+
+
+
+
 /*
     CLS.
 */
@@ -441,7 +460,7 @@ void uc1701_cls(void)
   for(line = 0; line < 8; line++)
   {
     uc1701_cursor_move(line, 0);
-    for(column = 0; column < 102; column++)
+    for(column = 0; column < UC1701_WIDTH; column++)
       uc1701_write(0x00, UC1701_DATA);
   }
 }
@@ -453,12 +472,13 @@ void uc1701_cls(void)
    LCD power up.
 */
 
-void uc1701_power_up(void)
+void uc1701_power_on(void)
 {
-  // Power on.
   uc1701_pwr_on();
-  // Wait 200ms for the power to settle and the LCD to startup.
-  delay(_200ms_);
+}
+
+void uc1701_init(void)
+{
   // Set normal Y (not mirrored).
   uc1701_set_com_dir(UC1701_NORMAL_Y);
   // Set LCD's bias ratio to 1/9 (duty is 1/65 for eadogs102).
@@ -477,6 +497,14 @@ void uc1701_power_up(void)
   uc1701_cls();
 }
 
+void uc1701_power_up(void)
+{
+  uc1701_power_on();
+  // Wait for the power to settle and the LCD to startup.
+  delay(DELAY_MS(UC1701_POWER_UP_MS));
+  uc1701_init();
+}
+
 
 
 
@@ -497,6 +525,20 @@ void uc1701_power_down(void)
 
 
 
+/*
+    Backlight.
+*/
+
+#ifdef UC1701_BACKLIGHT
+void uc1701_backlight(uint8_t on)
+{
+  if(on) uc1701_bl_on(); else uc1701_bl_off();
+}
+#endif
+
+
+
+
 /*
     Print a single character.
 */
@@ -516,6 +558,18 @@ void uc1701_print_symbol(char symbol)
 
 
 
+/*
+    Print a single 8 pixel high column.
+*/
+
+void uc1701_print_column(uint8_t bitmap)
+{
+  uc1701_write(bitmap, UC1701_DATA);
+}
+
+
+
+
 /*
     Print a program flash stored string at the cursor's current position.
 */
@@ -631,3 +685,157 @@ void uc1701_print_hex_u16(uint16_t value)
 }
 #endif
 
+
+
+
+
+/*
+    Print a single big digit, 'scale' (2 or 3) times the size of a charset digit.
+*/
+
+#if defined(UC1701_BIG_DIGITS_2X) || defined(UC1701_BIG_DIGITS_3X)
+void uc1701_print_big_digit(uint8_t line, uint8_t column, uint8_t digit, uint8_t scale)
+{
+  uint8_t page, i, width;
+  PGM_P bitmap;
+  // get the digit's starting address in the table of the requested size
+  #if defined(UC1701_BIG_DIGITS_2X) && defined(UC1701_BIG_DIGITS_3X)
+  bitmap = (scale == 2) ? big_digits_2x + digit * 20 : big_digits_3x + digit * 45;
+  #elif defined(UC1701_BIG_DIGITS_2X)
+  bitmap = big_digits_2x + digit * 20; scale = 2;
+  #else
+  bitmap = big_digits_3x + digit * 45; scale = 3;
+  #endif
+  width = scale * 5;
+  // send one burst of bitmap bytes per display page
+  for(page = 0; page < scale; page++)
+  {
+    uc1701_cursor_move(line + page, column);
+    for(i = 0; i < width; i++)
+      uc1701_write(digit > 9 ? 0x00 : pgm_read_byte_near(bitmap++), UC1701_DATA);
+    // add the blank separator columns next to the digit
+    for(i = 0; i < scale; i++)
+      uc1701_write(0x00, UC1701_DATA);
+  }
+}
+#endif
+
+
+
+
+/*
+    Print a 16 bit decimal number in big digits, starting at display 'line' and 'column'.
+*/
+
+#ifdef UC1701_PRINT_BIG_DEC_U16
+void uc1701_print_big_dec_u16(uint8_t line, uint8_t column, uint16_t value, uint8_t scale)
+{
+  uint16_t i;
+  uint8_t lead = 1;
+  // leading zeros are drawn blank, up to the last digit
+  i = 0; while(value >= 10000) { value -= 10000; i++; } if(i) lead = 0;
+  uc1701_print_big_digit(line, column, lead ? UC1701_BIG_BLANK : i, scale); column += scale;
+  i = 0; while(value >= 1000) { value -= 1000; i++; } if(i) lead = 0;
+  uc1701_print_big_digit(line, column, lead ? UC1701_BIG_BLANK : i, scale); column += scale;
+  i = 0; while(value >= 100) { value -= 100; i++; } if(i) lead = 0;
+  uc1701_print_big_digit(line, column, lead ? UC1701_BIG_BLANK : i, scale); column += scale;
+  i = 0; while(value >= 10) { value -= 10; i++; } if(i) lead = 0;
+  uc1701_print_big_digit(line, column, lead ? UC1701_BIG_BLANK : i, scale); column += scale;
+  uc1701_print_big_digit(line, column, value, scale);
+}
+#endif
+
+
+
+
+/*
+    Print a single proportional charset symbol at pixel column 'x' of the current line,
+    clipped at the display's right edge. Returns the pixel column following the symbol.
+*/
+
+#if defined(UC1701_PRINT_PROP_STR) || defined(UC1701_PRINT_PROP_STR_P)
+uint8_t uc1701_print_prop_symbol(uint8_t x, char symbol)
+{
+  uint8_t width;
+  // look up the symbol's width and starting address, indexed by the symbol's ascii code
+  symbol -= 32;
+  width = pgm_read_byte_near(prop_charset_width + symbol);
+  PGM_P symbol_address = prop_charset + pgm_read_word_near(prop_charset_offset + symbol);
+  // send the symbol's bitmap bytes and a blank separator column, up to the right edge
+  while(width-- && x < UC1701_WIDTH) { uc1701_write(pgm_read_byte_near(symbol_address++), UC1701_DATA); x++; }
+  if(x < UC1701_WIDTH) { uc1701_write(0x00, UC1701_DATA); x++; }
+  return x;
+}
+#endif
+
+
+
+
+/*
+    Print a SRAM stored string in the proportional charset.
+*/
+
+#ifdef UC1701_PRINT_PROP_STR
+uint8_t uc1701_print_prop_str(uint8_t line, uint8_t x, char *text)
+{
+  uc1701_cursor_move_px(line, x);
+  while(*text != '\0' && x < UC1701_WIDTH) x = uc1701_print_prop_symbol(x, *text++);
+  return x;
+}
+#endif
+
+
+
+
+/*
+    Print a program flash stored string in the proportional charset.
+*/
+
+#ifdef UC1701_PRINT_PROP_STR_P
+uint8_t uc1701_print_prop_str_P(uint8_t line, uint8_t x, PGM_P text)
+{
+  uint8_t buff;
+  uc1701_cursor_move_px(line, x);
+  while( (buff = pgm_read_byte_near(text++)) != '\0' && x < UC1701_WIDTH ) x = uc1701_print_prop_symbol(x, buff);
+  return x;
+}
+#endif
+
+
+
+
+/*
+    Draw a program flash stored bitmap at pixel column 'x' and pixel row 'y'.
+*/
+
+#ifdef UC1701_BLIT_P
+void uc1701_blit_P(PGM_P bitmap, uint8_t x, uint8_t y, uint8_t width, uint8_t height)
+{
+  uint8_t carry[UC1701_BLIT_MAX_WIDTH];
+  uint8_t line = y >> 3, shift = y & 0x07;
+  uint8_t pages = (height + 7) >> 3, covered = (shift + height + 7) >> 3;
+  uint8_t columns = width, page, i;
+  uint16_t bits;
+
+  // clip at the right and bottom edges
+  if(x >= UC1701_WIDTH || line >= UC1701_LINES) return;
+  if(columns > UC1701_WIDTH - x) columns = UC1701_WIDTH - x;
+  if(columns > UC1701_BLIT_MAX_WIDTH) columns = UC1701_BLIT_MAX_WIDTH;
+  if(covered > UC1701_LINES - line) covered = UC1701_LINES - line;
+
+  for(i = 0; i < columns; i++) carry[i] = 0x00;
+
+  for(page = 0; page < covered; page++)
+  {
+    uc1701_cursor_move_px(line + page, x);
+    for(i = 0; i < columns; i++)
+    {
+      // shift the bitmap byte into place, merging in the part carried from the page above
+      bits = (page < pages) ? pgm_read_byte_near(bitmap + i) << shift : 0;
+      uc1701_write(carry[i] | (uint8_t) bits, UC1701_DATA);
+      carry[i] = bits >> 8;
+    }
+    bitmap += width;
+  }
+}
+#endif
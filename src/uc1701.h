@@ -12,12 +12,29 @@
 
 // ___ Setup _____________________________________________________________________________________
 
+/*
+    Display width in pixels and height in lines (8 pixels each).
+*/
+#define UC1701_WIDTH 102
+#define UC1701_LINES 8
+
+
+
+
 /*
     Set the contrast
 */
 #define UC1701_CONTRAST 0x08
 
 
+
+
+/*
+    Time in mS for the power to settle and the LCD to start up, from power on to init.
+*/
+#define UC1701_POWER_UP_MS 200
+
+
 /*
     Ports, direction registers, and bits.
 */
@@ -51,14 +68,14 @@
 
 
 /*
-    SCLK half period Delay in uS.
+    SCLK half period Delay in nS.
 
     Uncomment the line bellow
-    to insert a delay routine
+    to insert an inline delay
     in the 'sclk_pulse()' code.
 */
 
-// #define UC1701_SCLK_DELAY _1us_
+// #define UC1701_SCLK_DELAY_NS 25
 
 
 
@@ -68,6 +85,7 @@
 */
 
 #define UC1701_CURSOR_MOVE
+#define UC1701_CURSOR_MOVE_PX
 #define UC1701_PRINT_STR_P
 #define UC1701_PRINT_STR
 #define UC1701_PRINT_DEC_U8
@@ -75,6 +93,32 @@
 #define UC1701_PRINT_DEC_U16
 #define UC1701_PRINT_HEX_U8
 #define UC1701_PRINT_HEX_U16
+#define UC1701_PRINT_BIG_DEC_U16  // depends on UC1701_CURSOR_MOVE and one of the big digit sizes.
+#define UC1701_PRINT_PROP_STR     // depends on UC1701_CURSOR_MOVE_PX.
+#define UC1701_PRINT_PROP_STR_P   // depends on UC1701_CURSOR_MOVE_PX.
+#define UC1701_BLIT_P             // depends on UC1701_CURSOR_MOVE_PX.
+#define UC1701_BACKLIGHT
+
+
+
+
+/*
+    Widest bitmap 'uc1701_blit_P()' can draw. Wider bitmaps are clipped.
+    Sets the size of the column scratch buffer it keeps on the stack.
+*/
+
+#define UC1701_BLIT_MAX_WIDTH 32
+
+
+
+
+/*
+   Big digit sizes compiled in (see uc1701_big_digits.h).
+   Comment out the sizes you don't need to preserve program memory space.
+*/
+
+#define UC1701_BIG_DIGITS_2X
+// #define UC1701_BIG_DIGITS_3X
 
 
 
@@ -125,6 +169,17 @@ void uc1701_cursor_move(uint8_t line, uint8_t column);
 
 
 
+/*
+    Sets the LCD's data address to display 'line' and pixel column 'x' (0 - 101).
+*/
+
+#ifdef UC1701_CURSOR_MOVE_PX
+void uc1701_cursor_move_px(uint8_t line, uint8_t x);
+#endif
+
+
+
+
 /*
     CLS.
 */
@@ -135,7 +190,17 @@ void uc1701_cls(void);
 
 
 /*
-   LCD power up.
+    Set the display's start line (0 - 63). The display shows the memory starting at
+    this pixel line, wrapping around, so changing it scrolls the whole display vertically.
+*/
+
+void uc1701_set_scroll_line(uint8_t scroll_line);
+
+
+
+
+/*
+   LCD power up. Power on, wait UC1701_POWER_UP_MS, then init.
 */
 
 void uc1701_power_up(void);
@@ -143,6 +208,17 @@ void uc1701_power_up(void);
 
 
 
+/*
+    The two halves of 'uc1701_power_up()', for callers having other work to do while the LCD starts up.
+    'uc1701_init()' sets the LCD up and clears it, UC1701_POWER_UP_MS after 'uc1701_power_on()'.
+*/
+
+void uc1701_power_on(void);
+void uc1701_init(void);
+
+
+
+
 /*
     LCD power down.
 */
@@ -152,6 +228,17 @@ void uc1701_power_down(void);
 
 
 
+/*
+    Turn the backlight on ('on' 1) or off ('on' 0). It is off after power up and power down.
+*/
+
+#ifdef UC1701_BACKLIGHT
+void uc1701_backlight(uint8_t on);
+#endif
+
+
+
+
 /*
     Print a single character.
 */
@@ -161,6 +248,16 @@ void uc1701_print_symbol(char symbol);
 
 
 
+/*
+    Print a single 8 pixel high column at the cursor's current position.
+    Bit 0 is the column's top pixel.
+*/
+
+void uc1701_print_column(uint8_t bitmap);
+
+
+
+
 /*
     Print a program flash stored string at the cursor's current position.
 */
@@ -238,5 +335,85 @@ void uc1701_print_hex_u16(uint16_t value);
 
 
 
+/*
+    Print a single big digit, 'scale' (2 or 3) times the size of a charset digit.
+
+    The digit's top left corner is placed at display 'line' and 'column',
+    as addressed by 'uc1701_cursor_move()'. The digit spans 'scale' lines and 'scale' columns.
+    Any 'digit' above 9 (UC1701_BIG_BLANK) clears the digit's area instead.
+    Takes 30 (2x) or 63 (3x) byte writes, about 1ms or 2ms at 8MHz.
+*/
+
+#define UC1701_BIG_BLANK 10
+
+#if defined(UC1701_BIG_DIGITS_2X) || defined(UC1701_BIG_DIGITS_3X)
+void uc1701_print_big_digit(uint8_t line, uint8_t column, uint8_t digit, uint8_t scale);
+#endif
+
+
+
+
+/*
+    Print a 16 bit decimal number in big digits, starting at display 'line' and 'column'.
+    Always 5 digits wide, leading zeros blanked.
+*/
+
+#ifdef UC1701_PRINT_BIG_DEC_U16
+void uc1701_print_big_dec_u16(uint8_t line, uint8_t column, uint16_t value, uint8_t scale);
+#endif
+
+
+
+
+/*
+    Print a SRAM stored string in the proportional charset (see uc1701_prop_charset.h),
+    starting at display 'line' and pixel column 'x'. Text running past the display's
+    right edge is clipped. Returns the pixel column following the text.
+
+    A line holds about 20 characters of mixed case text, against 17 in the fixed width charset,
+    and each character costs its width plus one byte writes, against a fixed 6.
+*/
+
+#ifdef UC1701_PRINT_PROP_STR
+uint8_t uc1701_print_prop_str(uint8_t line, uint8_t x, char *text);
+#endif
+
+
+
+
+/*
+    Print a program flash stored string in the proportional charset,
+    starting at display 'line' and pixel column 'x'. Returns the pixel column following the text.
+*/
+
+#ifdef UC1701_PRINT_PROP_STR_P
+uint8_t uc1701_print_prop_str_P(uint8_t line, uint8_t x, PGM_P text);
 #endif
 
+
+
+
+/*
+    Draw a program flash stored bitmap with its top left corner at pixel column 'x' and pixel row 'y'.
+
+    The bitmap is stored page after page, 'width' bytes per page and (height + 7) / 8 pages,
+    one byte per column with bit 0 at the top, the same as the display's memory.
+    Any 'y' is allowed. Each bitmap byte is shifted once and split between two display pages,
+    the part going to the next page being kept in a column scratch buffer.
+    The bitmap is clipped at the display's right and bottom edges.
+
+    The display can't be read back through the serial interface, so the pixels of the
+    partially covered pages, above and below the bitmap, are cleared.
+
+    Every covered display page costs one burst of 3 address bytes and 'width' data bytes,
+    so a 16x16 icon costs 2 bursts when 'y' is a multiple of 8 and 3 bursts otherwise.
+*/
+
+#ifdef UC1701_BLIT_P
+void uc1701_blit_P(PGM_P bitmap, uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+#endif
+
+
+
+
+#endif
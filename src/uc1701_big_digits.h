@@ -0,0 +1,110 @@
+/*
+	Large digit bitmaps for the UC1701 display driver.
+
+	The digits of the latin charset pre-scaled 2x and 3x, so that a big digit
+	is drawn as a straight burst of bytes, with no scaling done at run time.
+	A 'scale' times digit spans 'scale' display pages. The bitmap data of each
+	digit are stored page after page, 5 * 'scale' bytes per page.
+
+	Flash cost : 200 bytes for the 2x digits, 450 bytes for the 3x digits.
+	Each table is compiled in only when enabled in uc1701.h.
+*/
+
+#ifndef __UC1701_BIG_DIGITS__
+#define __UC1701_BIG_DIGITS__
+
+#include <avr/pgmspace.h>
+
+
+
+
+#ifdef UC1701_BIG_DIGITS_2X
+
+const char big_digits_2x[] PROGMEM = {
+                                          // bitmap data                                                 symbol  page
+
+                                          0xfc, 0xfc, 0x03, 0x03, 0xc3, 0xc3, 0x33, 0x33, 0xfc, 0xfc, // 0       0
+                                          0x0f, 0x0f, 0x33, 0x33, 0x30, 0x30, 0x30, 0x30, 0x0f, 0x0f, // 0       1
+
+                                          0x00, 0x00, 0x0c, 0x0c, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, // 1       0
+                                          0x00, 0x00, 0x30, 0x30, 0x3f, 0x3f, 0x30, 0x30, 0x00, 0x00, // 1       1
+
+                                          0x0c, 0x0c, 0x03, 0x03, 0x03, 0x03, 0xc3, 0xc3, 0x3c, 0x3c, // 2       0
+                                          0x30, 0x30, 0x3c, 0x3c, 0x33, 0x33, 0x30, 0x30, 0x30, 0x30, // 2       1
+
+                                          0x03, 0x03, 0x03, 0x03, 0x33, 0x33, 0xcf, 0xcf, 0x03, 0x03, // 3       0
+                                          0x0c, 0x0c, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x0f, 0x0f, // 3       1
+
+                                          0xc0, 0xc0, 0x30, 0x30, 0x0c, 0x0c, 0xff, 0xff, 0x00, 0x00, // 4       0
+                                          0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x3f, 0x3f, 0x03, 0x03, // 4       1
+
+                                          0x3f, 0x3f, 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xc3, 0xc3, // 5       0
+                                          0x0c, 0x0c, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x0f, 0x0f, // 5       1
+
+                                          0xf0, 0xf0, 0xcc, 0xcc, 0xc3, 0xc3, 0xc3, 0xc3, 0x00, 0x00, // 6       0
+                                          0x0f, 0x0f, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x0f, 0x0f, // 6       1
+
+                                          0x03, 0x03, 0x03, 0x03, 0xc3, 0xc3, 0x33, 0x33, 0x0f, 0x0f, // 7       0
+                                          0x00, 0x00, 0x3f, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 7       1
+
+                                          0x3c, 0x3c, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0x3c, 0x3c, // 8       0
+                                          0x0f, 0x0f, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x0f, 0x0f, // 8       1
+
+                                          0x3c, 0x3c, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xfc, 0xfc, // 9       0
+                                          0x00, 0x00, 0x30, 0x30, 0x30, 0x30, 0x0c, 0x0c, 0x03, 0x03  // 9       1
+                                        };
+
+#endif
+
+
+
+
+#ifdef UC1701_BIG_DIGITS_3X
+
+const char big_digits_3x[] PROGMEM = {
+                                          // bitmap data                                                                               symbol  page
+
+                                          0xf8, 0xf8, 0xf8, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xc7, 0xc7, 0xc7, 0xf8, 0xf8, 0xf8, // 0       0
+                                          0xff, 0xff, 0xff, 0x70, 0x70, 0x70, 0x0e, 0x0e, 0x0e, 0x01, 0x01, 0x01, 0xff, 0xff, 0xff, // 0       1
+                                          0x03, 0x03, 0x03, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x03, 0x03, 0x03, // 0       2
+
+                                          0x00, 0x00, 0x00, 0x38, 0x38, 0x38, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 1       0
+                                          0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 1       1
+                                          0x00, 0x00, 0x00, 0x1c, 0x1c, 0x1c, 0x1f, 0x1f, 0x1f, 0x1c, 0x1c, 0x1c, 0x00, 0x00, 0x00, // 1       2
+
+                                          0x38, 0x38, 0x38, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xf8, 0xf8, 0xf8, // 2       0
+                                          0x00, 0x00, 0x00, 0x80, 0x80, 0x80, 0x70, 0x70, 0x70, 0x0e, 0x0e, 0x0e, 0x01, 0x01, 0x01, // 2       1
+                                          0x1c, 0x1c, 0x1c, 0x1f, 0x1f, 0x1f, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, // 2       2
+
+                                          0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xc7, 0xc7, 0xc7, 0x3f, 0x3f, 0x3f, 0x07, 0x07, 0x07, // 3       0
+                                          0x80, 0x80, 0x80, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x0e, 0x0e, 0x0e, 0xf0, 0xf0, 0xf0, // 3       1
+                                          0x03, 0x03, 0x03, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x03, 0x03, 0x03, // 3       2
+
+                                          0x00, 0x00, 0x00, 0xc0, 0xc0, 0xc0, 0x38, 0x38, 0x38, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, // 4       0
+                                          0x7e, 0x7e, 0x7e, 0x71, 0x71, 0x71, 0x70, 0x70, 0x70, 0xff, 0xff, 0xff, 0x70, 0x70, 0x70, // 4       1
+                                          0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x1f, 0x1f, 0x00, 0x00, 0x00, // 4       2
+
+                                          0xff, 0xff, 0xff, 0xc7, 0xc7, 0xc7, 0xc7, 0xc7, 0xc7, 0xc7, 0xc7, 0xc7, 0x07, 0x07, 0x07, // 5       0
+                                          0x81, 0x81, 0x81, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xfe, 0xfe, 0xfe, // 5       1
+                                          0x03, 0x03, 0x03, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x03, 0x03, 0x03, // 5       2
+
+                                          0xc0, 0xc0, 0xc0, 0x38, 0x38, 0x38, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x00, 0x00, 0x00, // 6       0
+                                          0xff, 0xff, 0xff, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0xf0, 0xf0, 0xf0, // 6       1
+                                          0x03, 0x03, 0x03, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x03, 0x03, 0x03, // 6       2
+
+                                          0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xc7, 0xc7, 0xc7, 0x3f, 0x3f, 0x3f, // 7       0
+                                          0x00, 0x00, 0x00, 0xf0, 0xf0, 0xf0, 0x0e, 0x0e, 0x0e, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, // 7       1
+                                          0x00, 0x00, 0x00, 0x1f, 0x1f, 0x1f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 7       2
+
+                                          0xf8, 0xf8, 0xf8, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xf8, 0xf8, 0xf8, // 8       0
+                                          0xf1, 0xf1, 0xf1, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0xf1, 0xf1, 0xf1, // 8       1
+                                          0x03, 0x03, 0x03, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x03, 0x03, 0x03, // 8       2
+
+                                          0xf8, 0xf8, 0xf8, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xf8, 0xf8, 0xf8, // 9       0
+                                          0x01, 0x01, 0x01, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x8e, 0x8e, 0x8e, 0x7f, 0x7f, 0x7f, // 9       1
+                                          0x00, 0x00, 0x00, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x03, 0x03, 0x03, 0x00, 0x00, 0x00  // 9       2
+                                        };
+
+#endif
+
+#endif
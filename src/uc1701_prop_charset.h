@@ -0,0 +1,146 @@
+/*
+	Proportional latin charset for the UC1701 display driver.
+
+	The glyphs of the fixed width latin charset with their blank columns trimmed
+	(and a few narrow letters thinned), packed back to back. Digits keep their full
+	width so that numbers stay aligned.
+
+	'prop_charset_width' holds each glyph's width in columns and 'prop_charset_offset'
+	each glyph's starting index in 'prop_charset', so a glyph is found with two table
+	lookups, indexed by the symbol's ascii code minus 32.
+
+	Flash cost : 416 bytes of bitmap data, 95 bytes of widths and 190 bytes of offsets
+	(701 bytes, against 475 bytes for the fixed width charset).
+*/
+
+#ifndef __UC1701_PROP_CHARSET__
+#define __UC1701_PROP_CHARSET__
+
+#include <avr/pgmspace.h>
+
+const char prop_charset[] PROGMEM = {
+                                          // bitmap data                   symbol  dec  hex
+
+                                          0x00, 0x00,                    // space   32   0x20
+                                          0x4f,                          // !       33   0x21
+                                          0x07, 0x00, 0x07,              // "       34   0x22
+                                          0x14, 0x7f, 0x14, 0x7f, 0x14,  // #       35   0x23
+                                          0x24, 0x2a, 0x7f, 0x2a, 0x12,  // $       36   0x24
+                                          0x23, 0x13, 0x08, 0x64, 0x62,  // %       37   0x25
+                                          0x36, 0x49, 0x55, 0x22, 0x50,  // &       38   0x26
+                                          0x05, 0x03,                    // '       39   0x27
+                                          0x1c, 0x22, 0x41,              // (       40   0x28
+                                          0x41, 0x22, 0x1c,              // )       41   0x29
+                                          0x14, 0x08, 0x3e, 0x08, 0x14,  // *       42   0x2a
+                                          0x08, 0x08, 0x3e, 0x08, 0x08,  // +       43   0x2b
+                                          0x50, 0x30,                    // ,       44   0x2c
+                                          0x08, 0x08, 0x08, 0x08, 0x08,  // -       45   0x2d
+                                          0x60, 0x60,                    // .       46   0x2e
+                                          0x20, 0x10, 0x08, 0x04, 0x02,  // /       47   0x2f
+                                          0x3e, 0x51, 0x49, 0x45, 0x3e,  // 0       48   0x30
+                                          0x00, 0x42, 0x7f, 0x40, 0x00,  // 1       49   0x31
+                                          0x42, 0x61, 0x51, 0x49, 0x46,  // 2       50   0x32
+                                          0x21, 0x41, 0x45, 0x4b, 0x31,  // 3       51   0x33
+                                          0x18, 0x14, 0x12, 0x7f, 0x10,  // 4       52   0x34
+                                          0x27, 0x45, 0x45, 0x45, 0x39,  // 5       53   0x35
+                                          0x3c, 0x4a, 0x49, 0x49, 0x30,  // 6       54   0x36
+                                          0x01, 0x71, 0x09, 0x05, 0x03,  // 7       55   0x37
+                                          0x36, 0x49, 0x49, 0x49, 0x36,  // 8       56   0x38
+                                          0x06, 0x49, 0x49, 0x29, 0x1e,  // 9       57   0x39
+                                          0x36, 0x36,                    // :       58   0x3a
+                                          0x56, 0x36,                    // ;       59   0x3b
+                                          0x08, 0x14, 0x22, 0x41,        // <       60   0x3c
+                                          0x14, 0x14, 0x14, 0x14, 0x14,  // =       61   0x3d
+                                          0x41, 0x22, 0x14, 0x08,        // >       62   0x3e
+                                          0x02, 0x01, 0x51, 0x09, 0x06,  // ?       63   0x3f
+                                          0x32, 0x49, 0x79, 0x41, 0x3e,  // @       64   0x40
+                                          0x7e, 0x11, 0x11, 0x11, 0x7e,  // A       65   0x41
+                                          0x7f, 0x49, 0x49, 0x49, 0x36,  // B       66   0x42
+                                          0x3e, 0x41, 0x41, 0x41, 0x22,  // C       67   0x43
+                                          0x7f, 0x41, 0x41, 0x22, 0x1c,  // D       68   0x44
+                                          0x7f, 0x49, 0x49, 0x49, 0x41,  // E       69   0x45
+                                          0x7f, 0x09, 0x09, 0x09, 0x01,  // F       70   0x46
+                                          0x3e, 0x41, 0x49, 0x49, 0x7a,  // G       71   0x47
+                                          0x7f, 0x08, 0x08, 0x08, 0x7f,  // H       72   0x48
+                                          0x41, 0x7f, 0x41,              // I       73   0x49
+                                          0x20, 0x40, 0x41, 0x3f, 0x01,  // J       74   0x4a
+                                          0x7f, 0x08, 0x14, 0x22, 0x41,  // K       75   0x4b
+                                          0x7f, 0x40, 0x40, 0x40, 0x40,  // L       76   0x4c
+                                          0x7f, 0x02, 0x0c, 0x02, 0x7f,  // M       77   0x4d
+                                          0x7f, 0x04, 0x08, 0x10, 0x7f,  // N       78   0x4e
+                                          0x3e, 0x41, 0x41, 0x41, 0x3e,  // O       79   0x4f
+                                          0x7f, 0x09, 0x09, 0x09, 0x06,  // P       80   0x50
+                                          0x3e, 0x41, 0x51, 0x21, 0x5e,  // Q       81   0x51
+                                          0x7f, 0x09, 0x19, 0x29, 0x46,  // R       82   0x52
+                                          0x46, 0x49, 0x49, 0x49, 0x31,  // S       83   0x53
+                                          0x01, 0x01, 0x7f, 0x01, 0x01,  // T       84   0x54
+                                          0x3f, 0x40, 0x40, 0x40, 0x3f,  // U       85   0x55
+                                          0x1f, 0x20, 0x40, 0x20, 0x1f,  // V       86   0x56
+                                          0x3f, 0x40, 0x38, 0x40, 0x3f,  // W       87   0x57
+                                          0x63, 0x14, 0x08, 0x14, 0x63,  // X       88   0x58
+                                          0x07, 0x08, 0x70, 0x08, 0x07,  // Y       89   0x59
+                                          0x61, 0x51, 0x49, 0x45, 0x43,  // Z       90   0x5a
+                                          0x7f, 0x41, 0x41,              // [       91   0x5b
+                                          0x02, 0x04, 0x08, 0x10, 0x20,  // \       92   0x5c
+                                          0x41, 0x41, 0x7f,              // ]       93   0x5d
+                                          0x04, 0x02, 0x01, 0x02, 0x04,  // ^       94   0x5e
+                                          0x20, 0x20, 0x20, 0x20, 0x20,  // _       95   0x5f
+                                          0x01, 0x02, 0x04,              // `       96   0x60
+                                          0x20, 0x54, 0x54, 0x54, 0x78,  // a       97   0x61
+                                          0x7f, 0x50, 0x48, 0x48, 0x30,  // b       98   0x62
+                                          0x38, 0x44, 0x44, 0x44, 0x20,  // c       99   0x63
+                                          0x30, 0x48, 0x48, 0x50, 0x7f,  // d       100  0x64
+                                          0x38, 0x54, 0x54, 0x54, 0x18,  // e       101  0x65
+                                          0x08, 0x7e, 0x09,              // f       102  0x66
+                                          0x0c, 0x52, 0x52, 0x52, 0x3e,  // g       103  0x67
+                                          0x7f, 0x08, 0x04, 0x04, 0x78,  // h       104  0x68
+                                          0x7a,                          // i       105  0x69
+                                          0x20, 0x40, 0x44, 0x3d,        // j       106  0x6a
+                                          0x7f, 0x10, 0x28, 0x44,        // k       107  0x6b
+                                          0x41, 0x7f, 0x40,              // l       108  0x6c
+                                          0x7c, 0x04, 0x18, 0x04, 0x78,  // m       109  0x6d
+                                          0x7c, 0x08, 0x04, 0x04, 0x78,  // n       110  0x6e
+                                          0x38, 0x44, 0x44, 0x44, 0x38,  // o       111  0x6f
+                                          0x7c, 0x14, 0x14, 0x14, 0x08,  // p       112  0x70
+                                          0x08, 0x14, 0x14, 0x18, 0x7c,  // q       113  0x71
+                                          0x7c, 0x08, 0x04, 0x04,        // r       114  0x72
+                                          0x48, 0x54, 0x54, 0x54, 0x20,  // s       115  0x73
+                                          0x04, 0x3f, 0x44,              // t       116  0x74
+                                          0x3c, 0x40, 0x40, 0x20, 0x7c,  // u       117  0x75
+                                          0x1c, 0x20, 0x40, 0x20, 0x1c,  // v       118  0x76
+                                          0x3c, 0x40, 0x30, 0x40, 0x3c,  // w       119  0x77
+                                          0x44, 0x28, 0x10, 0x28, 0x44,  // x       120  0x78
+                                          0x0c, 0x50, 0x50, 0x50, 0x3c,  // y       121  0x79
+                                          0x44, 0x64, 0x54, 0x4c, 0x44,  // z       122  0x7a
+                                          0x08, 0x36, 0x41,              // {       123  0x7b
+                                          0x7f,                          // |       124  0x7c
+                                          0x41, 0x36, 0x08,              // }       125  0x7d
+                                          0x0c, 0x02, 0x0c, 0x10, 0x0c   // ~       126  0x7e
+                                        };
+
+
+
+
+const uint8_t prop_charset_width[] PROGMEM = {
+                                            2,   1,   3,   5,   5,   5,   5,   2,   3,   3,   5,   5,   2,   5,   2,   5,  // 32 - 47
+                                            5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   2,   2,   4,   5,   4,   5,  // 48 - 63
+                                            5,   5,   5,   5,   5,   5,   5,   5,   5,   3,   5,   5,   5,   5,   5,   5,  // 64 - 79
+                                            5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   3,   5,   3,   5,   5,  // 80 - 95
+                                            3,   5,   5,   5,   5,   5,   3,   5,   5,   1,   4,   4,   3,   5,   5,   5,  // 96 - 111
+                                            5,   5,   4,   5,   3,   5,   5,   5,   5,   5,   5,   3,   1,   3,   5  // 112 - 126
+                                        };
+
+
+
+
+const uint16_t prop_charset_offset[] PROGMEM = {
+                                            0,   2,   3,   6,  11,  16,  21,  26,  28,  31,  34,  39,  44,  46,  51,  53,  // 32 - 47
+                                           58,  63,  68,  73,  78,  83,  88,  93,  98, 103, 108, 110, 112, 116, 121, 125,  // 48 - 63
+                                          130, 135, 140, 145, 150, 155, 160, 165, 170, 175, 178, 183, 188, 193, 198, 203,  // 64 - 79
+                                          208, 213, 218, 223, 228, 233, 238, 243, 248, 253, 258, 263, 266, 271, 274, 279,  // 80 - 95
+                                          284, 287, 292, 297, 302, 307, 312, 315, 320, 325, 326, 330, 334, 337, 342, 347,  // 96 - 111
+                                          352, 357, 362, 366, 371, 374, 379, 384, 389, 394, 399, 404, 407, 408, 411  // 112 - 126
+                                        };
+
+
+#endif
@@ -0,0 +1,408 @@
+/*
+    catctl: host side reference client of the receiver's CAT protocol (see src/cat.h).
+
+    usage: catctl [-d device] [-w] command [arguments]
+
+      ping [count]            round trips with the receiver, reports min / average / max time.
+      tune freq               tune, in the band's units (10kHz in FM, 1kHz in AM).
+      seek up|down            scan for the next station.
+      band fm|mw|sw|off       select a band, or turn the radio off.
+      set property value      set a Si4735 property (numbers in C notation, e.g. 0x4000).
+      get property            get a Si4735 property.
+      rsq [count] [depth]     read 'count' signal quality snapshots, keeping up to 'depth' requests
+                              in flight, and report the sample rate.
+      stream tuned|rds|all    print the events enabled until interrupted.
+      telemetry rate          stream RSQ samples at 'rate' Hz, printed as CSV until interrupted
+                              (sequence number, time in ms, rssi, snr, multipath, freq offset).
+                              Gaps in the sequence are reported on stderr. Rate 0 stops.
+
+    -w sends a wake up byte first, for when the radio is off and the MCU sleeps.
+    'band' always does.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/select.h>
+#include <sys/time.h>
+
+#include "../../src/cat.h"
+
+
+
+
+/*
+    Setup
+*/
+
+#define DEVICE "/dev/ttyUSB0"
+#define BAUD B38400
+#define REPLY_TIMEOUT_MS 500
+
+
+
+
+/*
+    Serial line
+*/
+
+int line;
+
+int line_open(const char *device)
+{
+  struct termios tio;
+
+  line = open(device, O_RDWR | O_NOCTTY);
+  if(line < 0 || tcgetattr(line, &tio) < 0) { perror(device); return 0; }
+  cfmakeraw(&tio);
+  cfsetispeed(&tio, BAUD);
+  cfsetospeed(&tio, BAUD);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 0;
+  if(tcsetattr(line, TCSANOW, &tio) < 0) { perror(device); return 0; }
+  tcflush(line, TCIOFLUSH);
+  return 1;
+}
+
+double now_ms(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, 0);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+void wake(void)
+{
+  uint8_t byte = CAT_WAKE_BYTE;
+
+  if(write(line, &byte, 1) != 1) perror("write");
+  tcdrain(line);
+  usleep(CAT_WAKE_DELAY_MS * 1000);
+}
+
+
+
+
+/*
+    Frames
+*/
+
+void send_frame(uint8_t command, const uint8_t *data, uint8_t length)
+{
+  uint8_t frame[CAT_DATA_MAX + 4], check = command ^ length, i;
+
+  frame[0] = CAT_SYNC;
+  frame[1] = command;
+  frame[2] = length;
+  for(i = 0; i < length; i++) { frame[3 + i] = data[i]; check ^= data[i]; }
+  frame[3 + length] = check;
+  if(write(line, frame, length + 4) != length + 4) perror("write");
+}
+
+// Reads the next frame, waiting 'timeout_ms' at most (forever if negative). Returns 0 on timeout.
+int read_frame(struct cat_frame *frame, int timeout_ms)
+{
+  static int state;
+  static uint8_t count, check;
+  struct timeval tv;
+  fd_set fds;
+  uint8_t byte;
+
+  for(;;)
+  {
+    FD_ZERO(&fds);
+    FD_SET(line, &fds);
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = timeout_ms % 1000 * 1000;
+    if(select(line + 1, &fds, 0, 0, timeout_ms < 0 ? 0 : &tv) <= 0) { state = 0; return 0; }
+    if(read(line, &byte, 1) != 1) continue;
+
+    switch(state)
+    {
+      case 0 : if(byte == CAT_SYNC) state = 1; break;
+      case 1 : frame->command = check = byte; state = 2; break;
+      case 2 :
+        if(byte > CAT_DATA_MAX) { state = 0; break; }
+        frame->length = byte; check ^= byte; count = 0;
+        state = byte ? 3 : 4;
+        break;
+      case 3 :
+        frame->data[count++] = byte; check ^= byte;
+        if(count == frame->length) state = 4;
+        break;
+      case 4 :
+        state = 0;
+        if(byte == check) return 1;
+        fprintf(stderr, "bad check\n");
+        break;
+    }
+  }
+}
+
+const char *status_text(uint8_t status)
+{
+  switch(status)
+  {
+    case CAT_OK : return "ok";
+    case CAT_ERR_COMMAND : return "unknown command";
+    case CAT_ERR_LENGTH : return "bad length";
+    case CAT_ERR_VALUE : return "value out of range";
+    case CAT_ERR_OFF : return "radio off or busy";
+  }
+  return "?";
+}
+
+void print_event(struct cat_frame *frame)
+{
+  uint8_t *d = frame->data;
+
+  switch(frame->command)
+  {
+    case CAT_TUNED :
+      printf("tuned band %u freq %u%s\n", d[0], d[1] | d[2] << 8, d[3] ? " valid" : "");
+      break;
+    case CAT_RDS :
+      printf("rds %04x %04x %04x %04x errors %02x\n",
+             d[0] | d[1] << 8, d[2] | d[3] << 8, d[4] | d[5] << 8, d[6] | d[7] << 8, d[8]);
+      break;
+  }
+  fflush(stdout);
+}
+
+// Sends a command and waits for its reply, printing the events coming in between. Returns 0 on timeout or error.
+int transact(uint8_t command, const uint8_t *data, uint8_t length, struct cat_frame *reply)
+{
+  send_frame(command, data, length);
+  while(read_frame(reply, REPLY_TIMEOUT_MS))
+  {
+    if(reply->command != (command | CAT_REPLY)) { print_event(reply); continue; }
+    if(reply->length && reply->data[0] == CAT_OK) return 1;
+    fprintf(stderr, "error: %s\n", reply->length ? status_text(reply->data[0]) : "empty reply");
+    return 0;
+  }
+  fprintf(stderr, "no reply\n");
+  return 0;
+}
+
+
+
+
+/*
+    Commands
+*/
+
+int do_ping(int count)
+{
+  struct cat_frame reply;
+  uint8_t data[4];
+  double t, rtt, min = 1e9, max = 0, sum = 0;
+  int i;
+
+  for(i = 0; i < count; i++)
+  {
+    memcpy(data, &i, sizeof(data));
+    t = now_ms();
+    if(!transact(CAT_PING, data, sizeof(data), &reply)) return 1;
+    rtt = now_ms() - t;
+    if(reply.length != 1 + sizeof(data) || memcmp(reply.data + 1, data, sizeof(data))) { fprintf(stderr, "echo mismatch\n"); return 1; }
+    if(rtt < min) min = rtt;
+    if(rtt > max) max = rtt;
+    sum += rtt;
+  }
+  printf("%d round trips, min %.2f avg %.2f max %.2f ms\n", count, min, sum / count, max);
+  return 0;
+}
+
+int do_rsq(int count, int depth)
+{
+  struct cat_frame reply;
+  int sent = 0, received = 0;
+  double t = now_ms();
+
+  while(received < count)
+  {
+    while(sent < count && sent - received < depth) { send_frame(CAT_RSQ, 0, 0); sent++; }
+    if(!read_frame(&reply, REPLY_TIMEOUT_MS)) { fprintf(stderr, "no reply\n"); return 1; }
+    if(reply.command != (CAT_RSQ | CAT_REPLY)) { print_event(&reply); continue; }
+    received++;
+    if(reply.data[0] != CAT_OK) { fprintf(stderr, "error: %s\n", status_text(reply.data[0])); return 1; }
+    printf("rssi %u snr %u offset %d blend %u%s%s\n", reply.data[1], reply.data[2], (int8_t) reply.data[3], reply.data[4],
+           reply.data[5] & CAT_RSQ_VALID ? " valid" : "", reply.data[5] & CAT_RSQ_STEREO ? " stereo" : "");
+  }
+  t = now_ms() - t;
+  fprintf(stderr, "%d samples in %.0f ms, %.1f samples/s\n", count, t, count * 1000.0 / t);
+  return 0;
+}
+
+// The value nearest to 'estimate' that is 'value' modulo 'modulus'.
+int64_t unwrap(int64_t estimate, int64_t value, int64_t modulus)
+{
+  int64_t offset = (value - estimate) % modulus;
+
+  if(offset < 0) offset += modulus;
+  if(offset > modulus / 2) offset -= modulus;
+  return estimate + offset;
+}
+
+int do_telemetry(unsigned rate)
+{
+  struct cat_frame frame;
+  uint8_t data[2] = { rate & 0xff, rate >> 8 }, *d;
+  unsigned period_us, clock_us, count, i;
+  int64_t seq = 0, time = 0, next_seq = 0, skipped;
+  uint16_t last_time = 0, frame_time;
+  double last_ms = 0, ms;
+  int first = 1;
+
+  if(!transact(CAT_TELEMETRY_RATE, data, 2, &frame)) return 1;
+  if(!rate) return 0;
+  period_us = frame.data[1] | frame.data[2] << 8;
+  clock_us = frame.data[3];
+  fprintf(stderr, "sample period %u us\n", period_us);
+  printf("seq,time_ms,rssi,snr,mult,freqoff\n");
+
+  for(;;)
+  {
+    if(!read_frame(&frame, -1)) continue;
+    if(frame.command != CAT_TELEMETRY) { print_event(&frame); continue; }
+    d = frame.data;
+    count = (frame.length - 3) / 4;
+    frame_time = d[1] | d[2] << 8;
+    ms = now_ms();
+
+    // unwrap the 8 bit sequence number and the 16 bit time, in clock units.
+    // After a gap the 16 bit time may have wrapped any number of times: the time is re-synced from the
+    // samples skipped, told by the sequence number, itself unwrapped with the time elapsed on the host.
+    if(first) { seq = d[0]; time = frame_time; first = 0; }
+    else if((uint8_t)(d[0] - next_seq))
+    {
+      skipped = unwrap((ms - last_ms) * 1000 / period_us - (next_seq - seq), (uint8_t)(d[0] - next_seq), 256);
+      if(skipped < 0) skipped += 256;
+      fprintf(stderr, "gap of %lld samples\n", (long long)skipped);
+      time = unwrap(time + (next_seq + skipped - seq) * period_us / clock_us, frame_time, 0x10000);
+      seq = next_seq + skipped;
+    }
+    else
+    {
+      time += (uint16_t)(frame_time - last_time);
+      seq = next_seq;
+    }
+    last_time = frame_time;
+    last_ms = ms;
+    next_seq = seq + count;
+
+    for(i = 0; i < count; i++, d += 4)
+      printf("%lld,%.3f,%u,%u,%u,%d\n", (long long)(seq + i), ((double)time * clock_us + (double)i * period_us) / 1000.0,
+             d[3], d[4], d[5], (int8_t) d[6]);
+    fflush(stdout);
+  }
+}
+
+int do_stream(uint8_t mask)
+{
+  struct cat_frame frame;
+
+  if(!transact(CAT_STREAM, &mask, 1, &frame)) return 1;
+  for(;;) if(read_frame(&frame, -1)) print_event(&frame);
+}
+
+
+
+
+/*
+    Main
+*/
+
+void usage(void)
+{
+  fprintf(stderr, "usage: catctl [-d device] [-w] ping [count] | tune freq | seek up|down | band fm|mw|sw|off |\n"
+                  "              set property value | get property | rsq [count] [depth] | stream tuned|rds|all |\n"
+                  "              telemetry rate\n");
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  const char *device = DEVICE;
+  struct cat_frame reply;
+  uint8_t data[4];
+  unsigned long value;
+  int opt, wake_first = 0;
+
+  while((opt = getopt(argc, argv, "d:w")) != -1)
+  {
+    if(opt == 'd') device = optarg;
+    else if(opt == 'w') wake_first = 1;
+    else usage();
+  }
+  argc -= optind;
+  argv += optind;
+  if(argc < 1) usage();
+  if(!line_open(device)) return 1;
+  if(wake_first || !strcmp(argv[0], "band")) wake();
+
+  if(!strcmp(argv[0], "ping")) return do_ping(argc > 1 ? atoi(argv[1]) : 10);
+
+  if(!strcmp(argv[0], "rsq")) return do_rsq(argc > 1 ? atoi(argv[1]) : 100, argc > 2 ? atoi(argv[2]) : 1);
+
+  if(!strcmp(argv[0], "tune") && argc == 2)
+  {
+    value = strtoul(argv[1], 0, 0);
+    data[0] = value & 0xff; data[1] = value >> 8;
+    if(!transact(CAT_TUNE, data, 2, &reply)) return 1;
+    printf("%u\n", reply.data[1] | reply.data[2] << 8);
+    return 0;
+  }
+
+  if(!strcmp(argv[0], "seek") && argc == 2)
+  {
+    data[0] = strcmp(argv[1], "down") ? 1 : (uint8_t) -1;
+    return !transact(CAT_SEEK, data, 1, &reply);
+  }
+
+  if(!strcmp(argv[0], "band") && argc == 2)
+  {
+    if(!strcmp(argv[1], "fm")) data[0] = CAT_BAND_FM;
+    else if(!strcmp(argv[1], "mw")) data[0] = CAT_BAND_MW;
+    else if(!strcmp(argv[1], "sw")) data[0] = CAT_BAND_SW;
+    else if(!strcmp(argv[1], "off")) data[0] = CAT_BAND_OFF;
+    else usage();
+    return !transact(CAT_BAND, data, 1, &reply);
+  }
+
+  if(!strcmp(argv[0], "set") && argc == 3)
+  {
+    value = strtoul(argv[1], 0, 0);
+    data[0] = value & 0xff; data[1] = value >> 8;
+    value = strtoul(argv[2], 0, 0);
+    data[2] = value & 0xff; data[3] = value >> 8;
+    return !transact(CAT_SET_PROPERTY, data, 4, &reply);
+  }
+
+  if(!strcmp(argv[0], "get") && argc == 2)
+  {
+    value = strtoul(argv[1], 0, 0);
+    data[0] = value & 0xff; data[1] = value >> 8;
+    if(!transact(CAT_GET_PROPERTY, data, 2, &reply)) return 1;
+    printf("0x%04x\n", reply.data[1] | reply.data[2] << 8);
+    return 0;
+  }
+
+  if(!strcmp(argv[0], "telemetry") && argc == 2) return do_telemetry(strtoul(argv[1], 0, 0));
+
+  if(!strcmp(argv[0], "stream") && argc == 2)
+  {
+    if(!strcmp(argv[1], "tuned")) return do_stream(CAT_STREAM_TUNED);
+    if(!strcmp(argv[1], "rds")) return do_stream(CAT_STREAM_RDS);
+    if(!strcmp(argv[1], "all")) return do_stream(CAT_STREAM_TUNED | CAT_STREAM_RDS);
+  }
+
+  usage();
+  return 2;
+}
@@ -0,0 +1,19 @@
+/*
+    Host stand-in for <avr/interrupt.h>: interrupt handlers are plain functions, called by the tests.
+*/
+
+#ifndef __HOST_AVR_INTERRUPT__
+#define __HOST_AVR_INTERRUPT__
+
+#define ISR(vector) void vector(void)
+#define EMPTY_INTERRUPT(vector) void vector(void) {}
+#define cli()
+#define sei()
+
+#define PCINT0_vect pcint0_vect
+#define PCINT2_vect pcint2_vect
+#define TIMER0_OVF_vect timer0_ovf_vect
+#define USART_RX_vect usart_rx_vect
+#define USART_UDRE_vect usart_udre_vect
+
+#endif
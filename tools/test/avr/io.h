@@ -0,0 +1,43 @@
+/*
+    Host stand-in for <avr/io.h>: the registers the firmware modules under test use, as plain variables
+    defined in host.c. PIND is read through the keyboard model of host.c.
+*/
+
+#ifndef __HOST_AVR_IO__
+#define __HOST_AVR_IO__
+
+#include <stdint.h>
+
+#define HOST_REGISTER(name) extern volatile uint8_t name;
+
+HOST_REGISTER(PORTB) HOST_REGISTER(DDRB) HOST_REGISTER(PINB)
+HOST_REGISTER(PORTC) HOST_REGISTER(DDRC) HOST_REGISTER(PINC)
+HOST_REGISTER(PORTD) HOST_REGISTER(DDRD)
+HOST_REGISTER(PCMSK0) HOST_REGISTER(PCMSK1) HOST_REGISTER(PCMSK2) HOST_REGISTER(PCIFR) HOST_REGISTER(PCICR)
+HOST_REGISTER(TCNT0) HOST_REGISTER(TIFR0) HOST_REGISTER(SREG)
+HOST_REGISTER(UCSR0A) HOST_REGISTER(UCSR0B) HOST_REGISTER(UCSR0C) HOST_REGISTER(UDR0)
+
+extern volatile uint16_t UBRR0;
+
+volatile uint8_t *host_pind(void);
+#define PIND (*host_pind())
+
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCINT6 6
+#define PCINT7 7
+#define TOV0 0
+#define PCINT16 0
+#define U2X0 1
+#define TXC0 6
+#define UCSZ00 1
+#define UCSZ01 2
+#define RXCIE0 7
+#define RXEN0 4
+#define TXEN0 3
+#define UDRIE0 5
+
+#define _SFR_IO_ADDR(reg) 0
+
+#endif
@@ -0,0 +1,20 @@
+/*
+    Host stand-in for <avr/pgmspace.h>: program memory is ordinary memory.
+*/
+
+#ifndef __HOST_AVR_PGMSPACE__
+#define __HOST_AVR_PGMSPACE__
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*(const uint8_t *) (address))
+#define pgm_read_byte_near(address) (*(const uint8_t *) (address))
+#define pgm_read_word(address) (*(const uint16_t *) (address))
+#define pgm_read_word_near(address) (*(const uint16_t *) (address))
+#define memcpy_P memcpy
+
+#endif
@@ -0,0 +1,320 @@
+/*
+    CAT framing round trip through the UART driver, in loopback.
+
+    The UART's line is a wire from its transmitter to its receiver: every byte the data register empty interrupt
+    puts into UDR0 is received by the receive interrupt. Frames sent with cat_send() must come out of cat_poll()
+    unchanged, whole, in order, polled a few bytes at a time. Frames with a bad check or length, or left
+    unfinished for CAT_FRAME_TIMEOUT polls, must be dropped and counted, the parser picking up the next frame.
+    A frame not fitting in the transmit buffer must be dropped whole.
+
+    While the MCU sleeps, as main.c's idle() lets it with the UART and the parser idle, the line's bytes
+    are lost, the first one waking it up. A frame sent CAT_WAKE_DELAY_MS after CAT_WAKE_BYTE must be received,
+    and the MCU must sleep again once it has been. A frame sent after the wake up window must be lost.
+
+    The wire time of a command and its reply at UART_BAUD, and the line's top telemetry sample rate,
+    are reported from the bytes the frames take on the wire.
+*/
+
+#include <string.h>
+#include "host.h"
+#include "avr/io.h"
+#include "avr/interrupt.h"
+#include "../../src/uart.h"
+#include "../../src/cat.h"
+
+#define FRAMES 20000
+
+void usart_rx_vect(void);
+void usart_udre_vect(void);
+extern volatile uint8_t uart_tx_tail;
+
+// xorshift
+uint32_t random_state = 2463534242UL;
+
+uint32_t random_next(void)
+{
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+
+
+
+/*
+    Wire
+
+    Moves up to 'bytes' bytes from the transmit buffer to the receive buffer. Returns the bytes moved.
+    A byte reaching a sleeping MCU is lost and wakes it up.
+*/
+
+unsigned long wire_bytes;
+uint8_t asleep;
+
+unsigned wire(unsigned bytes)
+{
+  unsigned moved = 0;
+  uint8_t tail;
+
+  while(moved < bytes && (UCSR0B & (1 << UDRIE0)))
+  {
+    tail = uart_tx_tail;
+    usart_udre_vect();
+    if(uart_tx_tail == tail) break;
+    if(asleep) { asleep = 0; cat_wake(); }
+    else usart_rx_vect();
+    moved++;
+  }
+  wire_bytes += moved;
+  return moved;
+}
+
+// Sends raw bytes, e.g. a broken frame.
+void wire_raw(const uint8_t *bytes, uint8_t size)
+{
+  host_check(uart_write(bytes, size), "raw bytes not queued");
+  wire(size);
+}
+
+// Polls until a frame comes or nothing is left on the wire and the parser times out. Returns 0 for no frame.
+uint8_t receive(struct cat_frame *frame)
+{
+  unsigned polls;
+
+  for(polls = 0; polls <= CAT_FRAME_TIMEOUT + 1; polls++)
+  {
+    if(wire(1 + random_next() % 8)) polls = 0;
+    if(cat_poll(frame)) return 1;
+  }
+  return 0;
+}
+
+
+
+
+/*
+    Round trip
+*/
+
+void round_trip(void)
+{
+  struct cat_frame sent, received;
+  unsigned n, i;
+
+  for(n = 0; n < FRAMES; n++)
+  {
+    sent.command = random_next();
+    sent.length = random_next() % (CAT_DATA_MAX + 1);
+    for(i = 0; i < sent.length; i++) sent.data[i] = random_next();
+
+    host_check(cat_send(sent.command, sent.data, sent.length), "frame %u not sent", n);
+    host_check(receive(&received), "frame %u not received", n);
+    host_check(received.command == sent.command && received.length == sent.length &&
+      !memcmp(received.data, sent.data, sent.length), "frame %u received changed", n);
+    if(host_failures) return;
+  }
+  host_check(cat_errors == 0 && cat_idle(), "%u errors in good frames", cat_errors);
+}
+
+
+
+
+/*
+    Back to back: two frames in one poll, taken one per poll.
+*/
+
+void back_to_back(void)
+{
+  const uint8_t a[] = { 1 }, b[] = { 2, 3 };
+  struct cat_frame frame;
+
+  cat_send(CAT_PING, a, sizeof(a));
+  cat_send(CAT_RSQ, b, sizeof(b));
+  wire(100);
+  host_check(cat_poll(&frame) && frame.command == CAT_PING && frame.length == 1, "back to back: first frame");
+  host_check(cat_poll(&frame) && frame.command == CAT_RSQ && frame.length == 2 && frame.data[1] == 3,
+    "back to back: second frame");
+  host_check(!cat_poll(&frame), "back to back: third frame");
+}
+
+
+
+
+/*
+    Errors: each broken frame is dropped and counted, and the good frame following it received.
+*/
+
+const uint8_t bad_check[] = { CAT_SYNC, CAT_TUNE, 2, 0x10, 0x27, CAT_TUNE ^ 2 ^ 0x10 ^ 0x27 ^ 1 };
+const uint8_t bad_length[] = { CAT_SYNC, CAT_PING, CAT_DATA_MAX + 1 };
+const uint8_t unfinished[] = { CAT_SYNC, CAT_PING, 5, 1, 2 };
+const uint8_t noise[] = { 0x00, 0xff, 0x5a, 0x12 };
+
+void broken(const char *name, const uint8_t *bytes, uint8_t size, uint8_t errors)
+{
+  const uint8_t data[] = { 0x55, 0xaa };
+  struct cat_frame frame;
+  uint8_t before = cat_errors;
+
+  wire_raw(bytes, size);
+  host_check(!receive(&frame), "%s: frame received", name);
+  host_check((uint8_t)(cat_errors - before) == errors, "%s: %u errors", name, (uint8_t)(cat_errors - before));
+  host_check(cat_idle(), "%s: parser not back to sync", name);
+
+  cat_send(CAT_PING, data, sizeof(data));
+  host_check(receive(&frame) && frame.command == CAT_PING && frame.length == 2 && frame.data[1] == 0xaa,
+    "%s: next frame not received", name);
+}
+
+void errors(void)
+{
+  broken("bad check", bad_check, sizeof(bad_check), 1);
+  broken("bad length", bad_length, sizeof(bad_length), 1);
+  broken("unfinished", unfinished, sizeof(unfinished), 1);
+  broken("noise", noise, sizeof(noise), 0);
+}
+
+
+
+
+/*
+    Full transmit buffer: frames dropped whole.
+*/
+
+void full(void)
+{
+  uint8_t data[CAT_DATA_MAX] = { 0 };
+  unsigned sent = 0, received = 0;
+  uint8_t errors = cat_errors;
+  struct cat_frame frame;
+
+  while(cat_send(CAT_PING, data, CAT_DATA_MAX)) sent++;
+  host_check(cat_drops == 1, "full: %u drops", cat_drops);
+  while(receive(&frame)) received++;
+  host_check(received == sent && cat_errors == errors, "full: %u frames sent, %u received, %u errors",
+    sent, received, (uint8_t)(cat_errors - errors));
+}
+
+
+
+
+/*
+    Wake up: a poll is a scheduler tick, a timer 0 overflow as set up in main.c.
+*/
+
+#define TICK_US (256UL * 256 * 1000000 / F_CPU)
+#define WAKE_DELAY_POLLS ((CAT_WAKE_DELAY_MS * 1000UL + TICK_US - 1) / TICK_US)
+
+// main.c's idle(), as far as the UART goes.
+void idle(void)
+{
+  if(uart_idle() && cat_idle()) asleep = 1;
+}
+
+// Polls 'polls' times while awake, a few bytes coming before each poll. Returns the frames received.
+unsigned awake(unsigned polls, struct cat_frame *frame)
+{
+  unsigned frames = 0;
+
+  while(polls--)
+  {
+    wire(1 + random_next() % 8);
+    if(asleep) continue;
+    if(cat_poll(frame)) frames++;
+    idle();
+  }
+  return frames;
+}
+
+// Wakes the MCU up, waits 'delay' polls and sends a frame. Returns the frames received.
+unsigned wake_send(unsigned delay)
+{
+  const uint8_t wake = CAT_WAKE_BYTE, data[] = { 0x55, 0xaa };
+  struct cat_frame frame;
+  unsigned frames;
+
+  idle();
+  host_check(asleep, "wake up: not asleep");
+  uart_write(&wake, 1);
+  frames = awake(delay, &frame);
+  cat_send(CAT_PING, data, sizeof(data));
+  frames += awake(CAT_FRAME_TIMEOUT + CAT_WAKE_TIMEOUT + 2, &frame);
+  host_check(asleep, "wake up after %u polls: not asleep again", delay);
+  if(frames) host_check(frame.command == CAT_PING && frame.length == 2 && frame.data[1] == 0xaa,
+    "wake up after %u polls: frame received changed", delay);
+  return frames;
+}
+
+void wake_up(void)
+{
+  uint8_t errors = cat_errors;
+  unsigned delay;
+
+  for(delay = WAKE_DELAY_POLLS; delay < CAT_WAKE_TIMEOUT; delay++)
+    host_check(wake_send(delay) == 1, "wake up: frame sent %u polls after the wake byte lost", delay);
+  host_check(wake_send(CAT_WAKE_TIMEOUT + 1) == 0, "wake up: frame received once asleep again");
+  host_check(cat_errors == errors, "wake up: %u errors", (uint8_t)(cat_errors - errors));
+  asleep = 0;
+}
+
+
+
+
+/*
+    Wire time
+*/
+
+#define BYTE_US (10 * 1000000.0 / UART_BAUD)
+
+void wire_time(void)
+{
+  const uint8_t freq[] = { 0x2e, 0x22 }, reply_ok[] = { CAT_OK }, reply_tune[] = { CAT_OK, 0x2e, 0x22 };
+  const uint8_t reply_rsq[] = { CAT_OK, 40, 20, 0, 0, CAT_RSQ_VALID };
+  struct
+  {
+    const char *name;
+    uint8_t command;
+    const uint8_t *data, length;
+    const uint8_t *reply, reply_length;
+  } exchanges[] = {
+    { "ping", CAT_PING, 0, 0, reply_ok, 1 },
+    { "tune", CAT_TUNE, freq, 2, reply_tune, 3 },
+    { "rsq", CAT_RSQ, 0, 0, reply_rsq, 6 },
+  };
+  struct cat_frame frame;
+  unsigned long bytes;
+  unsigned i;
+
+  for(i = 0; i < sizeof(exchanges) / sizeof(exchanges[0]); i++)
+  {
+    bytes = wire_bytes;
+    cat_send(exchanges[i].command, exchanges[i].data, exchanges[i].length);
+    receive(&frame);
+    cat_send(exchanges[i].command | CAT_REPLY, exchanges[i].reply, exchanges[i].reply_length);
+    receive(&frame);
+    printf("%s: %lu bytes on the wire, %.0f us at %u baud\n", exchanges[i].name, wire_bytes - bytes,
+      (wire_bytes - bytes) * BYTE_US, UART_BAUD);
+  }
+
+  // the longest telemetry frame: sequence number, time and 3 samples of 4 bytes
+  printf("telemetry: %u byte frames of 3 samples, %.0f samples/s at most\n", 3 + 12 + 4,
+    3 * 1000000.0 / ((3 + 12 + 4) * BYTE_US));
+}
+
+
+
+
+int main(void)
+{
+  uart_init();
+
+  round_trip();
+  back_to_back();
+  errors();
+  full();
+  wake_up();
+  wire_time();
+  host_check(uart_overflows == 0, "%u bytes lost in the receive buffer", uart_overflows);
+
+  return host_result("cat_loopback");
+}
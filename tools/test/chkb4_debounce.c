@@ -0,0 +1,178 @@
+/*
+    chkb4 debouncing under contact bounce, on the keyboard model.
+
+    Two keys are pressed and released independently, over and over. Every press and release bounces:
+    the contact toggles a few times, each time for 1 to CHKB4_DEBOUNCE - 1 runs of chkb4_update(),
+    before it settles. Every press and release must give exactly one event, CHKB4_DEBOUNCE runs
+    after the contact settled. Single run glitches on an open key must give none.
+    The latency from the first touch of the contact and from its settling is reported.
+
+    The bounce patterns are pseudo-random from a fixed seed, so a run is reproducible.
+*/
+
+#include "host.h"
+#include "../../src/chkb4.h"
+
+#define TRIALS 2000
+#define BOUNCES_MAX 6
+#define HOLD_MIN (CHKB4_DEBOUNCE + 1)
+#define HOLD_MAX (CHKB4_REPEAT_DELAY - 1)
+
+#define RUN_US(runs) ((unsigned long)(runs) * CHKB4_PERIOD_US)
+
+// xorshift
+uint32_t random_state = 2463534242UL;
+
+uint32_t random_next(void)
+{
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+unsigned random_range(unsigned low, unsigned high)
+{
+  return low + random_next() % (high - low + 1);
+}
+
+
+
+
+/*
+    Contacts
+
+    A contact goes through its bounce segments, then holds its new level, then bounces back.
+    'runs' is the runs left in the segment, 'segments' the bounce segments left before the level settles.
+*/
+
+struct contact
+{
+  uint8_t key;
+  uint8_t closed;		// the contact's level now
+  uint8_t target;		// the level it is going to settle at
+  uint8_t segments;
+  unsigned runs;
+  uint16_t touch, settle;	// chkb4_time of the first touch and of the settling of the last change
+  unsigned presses, releases;
+  unsigned long touch_latency, settle_latency, touch_latency_max, changes;
+};
+
+struct contact contacts[2] = { { KEY_04 }, { KEY_09 } };
+
+// Starts a change of level: bounce segments of alternating levels, the last one at the old level.
+void contact_change(struct contact *c)
+{
+  c->target = !c->target;
+  c->segments = 2 * random_range(0, BOUNCES_MAX / 2);
+  c->closed = c->target;
+  c->runs = c->segments ? random_range(1, CHKB4_DEBOUNCE - 1) : random_range(HOLD_MIN, HOLD_MAX);
+  c->touch = chkb4_time + 1;
+  if(!c->segments) c->settle = c->touch;
+}
+
+// Steps the contact by one run, returns its level for the run.
+uint8_t contact_step(struct contact *c)
+{
+  if(c->runs == 0)
+  {
+    if(c->segments)
+    {
+      c->segments--;
+      c->closed = !c->closed;
+      if(c->segments)
+        c->runs = random_range(1, CHKB4_DEBOUNCE - 1);
+      else
+      {
+        c->runs = random_range(HOLD_MIN, HOLD_MAX);
+        c->settle = chkb4_time + 1;
+      }
+    }
+    else
+      contact_change(c);
+  }
+  c->runs--;
+  return c->closed;
+}
+
+void contact_event(struct contact *c, struct chkb4_event *event)
+{
+  uint16_t latency;
+
+  if(event->type == CHKB4_PRESS || event->type == CHKB4_RELEASE)
+  {
+    if(event->type == CHKB4_PRESS) c->presses++; else c->releases++;
+    host_check(event->type == (c->target ? CHKB4_PRESS : CHKB4_RELEASE),
+      "key %u: %s while the contact goes %s", c->key, event->type == CHKB4_PRESS ? "press" : "release",
+      c->target ? "closed" : "open");
+
+    latency = event->time - c->settle + 1;
+    host_check(latency == CHKB4_DEBOUNCE, "key %u: event %u runs after settling", c->key, latency);
+    c->settle_latency += latency;
+    latency = event->time - c->touch + 1;
+    c->touch_latency += latency;
+    if(latency > c->touch_latency_max) c->touch_latency_max = latency;
+    c->changes++;
+  }
+}
+
+
+
+
+/*
+    Glitches: single run closures of an open key.
+*/
+
+void glitches(void)
+{
+  struct chkb4_event event;
+  unsigned i, events = 0;
+
+  for(i = 0; i < 100; i++)
+  {
+    host_keys = 1UL << KEY_07;
+    chkb4_update();
+    host_keys = 0;
+    chkb4_update();
+    chkb4_update();
+    while(chkb4_get_event(&event)) events++;
+  }
+  host_check(events == 0, "glitches: %u events", events);
+}
+
+
+
+
+int main(void)
+{
+  struct chkb4_event event;
+  unsigned i, trials = 0;
+
+  chkb4_init();
+  glitches();
+
+  contact_change(&contacts[0]);
+  contact_change(&contacts[1]);
+  while(trials < TRIALS)
+  {
+    host_keys = 0;
+    for(i = 0; i < 2; i++) if(contact_step(&contacts[i])) host_keys |= 1UL << contacts[i].key;
+    chkb4_update();
+    while(chkb4_get_event(&event))
+      for(i = 0; i < 2; i++) if(event.key == contacts[i].key) contact_event(&contacts[i], &event);
+    trials = contacts[0].releases < contacts[1].releases ? contacts[0].releases : contacts[1].releases;
+  }
+
+  for(i = 0; i < 2; i++)
+  {
+    struct contact *c = &contacts[i];
+    host_check(c->presses == c->releases || c->presses == c->releases + 1,
+      "key %u: %u presses, %u releases", c->key, c->presses, c->releases);
+    printf("key %u: %u presses, latency from settling %lu us, from first touch %lu us mean, %lu us max\n",
+      c->key, c->presses, RUN_US(c->settle_latency) / c->changes, RUN_US(c->touch_latency) / c->changes,
+      RUN_US(c->touch_latency_max));
+  }
+  host_check(chkb4_overflows == 0, "%u events dropped", chkb4_overflows);
+
+  return host_result("chkb4_debounce");
+}
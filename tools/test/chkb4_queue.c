@@ -0,0 +1,177 @@
+/*
+    chkb4 key event queue under simulated interrupt interleavings.
+
+    The producer, chkb4_put_event() as called by chkb4_update() in the timer interrupt, preempts the consumer,
+    chkb4_get_event(), between any two of its instructions. On x86-64 Linux every consumer call is
+    single-stepped with the trap flag, and the SIGTRAP handler runs the producer after an instruction
+    1 time in PRODUCER_ODDS, as a burst of up to CHKB4_QUEUE_SIZE + 1 events 1 time in BURST_ODDS,
+    so that the queue fills up and overflows. The interleavings are pseudo-random from a fixed seed,
+    so a run is reproducible. Elsewhere the producer runs from SIGALRM every PRODUCER_PERIOD_US,
+    which preempts the consumer far less often.
+
+    Every event carries a sequence number in its time, and the key and type derived from it,
+    so a torn, duplicated, reordered or lost event shows. Every event must be received in order,
+    except the ones dropped, each counted in 'chkb4_overflows'.
+*/
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <sys/time.h>
+#include "host.h"
+#include "../../src/chkb4.h"
+
+#define CONSUMER_CALLS 50000
+#define PRODUCER_ODDS 32
+#define BURST_ODDS 16
+#define PRODUCER_PERIOD_US 20
+
+void chkb4_put_event(uint8_t key, uint8_t type);
+
+volatile unsigned long produced, dropped;
+
+void producer(void)
+{
+  uint8_t overflows = chkb4_overflows;
+
+  chkb4_time = ++produced;
+  chkb4_put_event(chkb4_time & 0xff, chkb4_time % CHKB4_EVENT_TYPES);
+  if(chkb4_overflows != overflows) dropped++;
+}
+
+// xorshift
+uint32_t random_state = 2463534242UL;
+
+uint32_t random_next(void)
+{
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+
+
+
+/*
+    Interleaving
+
+    'get_event()' is chkb4_get_event() preempted by the producer.
+*/
+
+#if defined(__linux__) && defined(__x86_64__)
+
+#include <ucontext.h>
+
+#define TRAP_FLAG 0x100
+volatile uint8_t stepping;
+unsigned long steps;
+
+void step(int signal, siginfo_t *info, void *context)
+{
+  ucontext_t *uc = context;
+  uint8_t burst;
+
+  if(!stepping) { uc->uc_mcontext.gregs[REG_EFL] &= ~TRAP_FLAG; return; }
+  steps++;
+  if(random_next() % PRODUCER_ODDS) return;
+  burst = random_next() % BURST_ODDS ? 1 : 1 + random_next() % (CHKB4_QUEUE_SIZE + 1);
+  while(burst--) producer();
+}
+
+void interleave_start(void)
+{
+  struct sigaction action = { 0 };
+
+  action.sa_sigaction = step;
+  action.sa_flags = SA_SIGINFO;
+  sigaction(SIGTRAP, &action, NULL);
+}
+
+void interleave_stop(void)
+{
+  printf("%lu consumer instructions stepped\n", steps);
+}
+
+uint8_t get_event(struct chkb4_event *event)
+{
+  uint8_t got;
+
+  stepping = 1;
+  asm volatile("pushfq; orq $0x100, (%%rsp); popfq" ::: "memory", "cc");
+  got = chkb4_get_event(event);
+  stepping = 0;
+  // the trap after the next instruction clears the flag
+  asm volatile("nop");
+  return got;
+}
+
+#else
+
+void tick(int signal)
+{
+  producer();
+}
+
+void interleave_start(void)
+{
+  struct itimerval period = { { 0, PRODUCER_PERIOD_US }, { 0, PRODUCER_PERIOD_US } };
+
+  signal(SIGALRM, tick);
+  setitimer(ITIMER_REAL, &period, NULL);
+}
+
+void interleave_stop(void)
+{
+  struct itimerval off = { { 0, 0 }, { 0, 0 } };
+
+  setitimer(ITIMER_REAL, &off, NULL);
+}
+
+uint8_t get_event(struct chkb4_event *event)
+{
+  volatile unsigned spin;
+
+  // let the queue fill up now and then
+  if(random_next() % 64 == 0) for(spin = random_next() % 1000000; spin; spin--);
+  return chkb4_get_event(event);
+}
+
+#endif
+
+
+
+
+/*
+    Consumer
+*/
+
+int main(void)
+{
+  struct chkb4_event event;
+  unsigned long received = 0, gaps = 0, calls;
+  uint16_t expected = 1;
+
+  interleave_start();
+  for(calls = 0; calls < CONSUMER_CALLS; calls++)
+  {
+    if(!get_event(&event)) continue;
+    host_check(event.key == (event.time & 0xff) && event.type == event.time % CHKB4_EVENT_TYPES,
+               "torn event: time %u key %u type %u", event.time, event.key, event.type);
+    host_check((int16_t) (event.time - expected) >= 0, "event %u out of order, expected %u", event.time, expected);
+    gaps += (uint16_t) (event.time - expected);
+    expected = event.time + 1;
+    received++;
+  }
+  interleave_stop();
+
+  while(chkb4_get_event(&event)) { gaps += (uint16_t) (event.time - expected); expected = event.time + 1; received++; }
+  // the events dropped at the end have no later event showing their gap
+  gaps += (uint16_t) ((uint16_t) produced + 1 - expected);
+
+  printf("produced %lu, received %lu, dropped %lu (chkb4_overflows %u)\n", produced, received, dropped, chkb4_overflows);
+  host_check(received + dropped == produced, "events lost without an overflow");
+  host_check(gaps == dropped, "gaps (%lu) don't match the overflows (%lu)", gaps, dropped);
+  host_check((uint8_t) dropped == chkb4_overflows, "chkb4_overflows doesn't count the drops");
+  host_check(dropped > 0, "the queue never filled up");
+  return host_result("chkb4_queue");
+}
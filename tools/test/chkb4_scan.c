@@ -0,0 +1,63 @@
+/*
+    chkb4 keyboard scan on the keyboard model, with the shipped line setup.
+
+    Every single key and every pair of keys is held on the model and chkb4_scan() must find exactly them,
+    in the key bits documented in chkb4.h. The model has no diode chains, so the pairs check the bit packing,
+    not ghosting. After every scan the lines must be back to inputs with pull-ups and the other bits of the port
+    untouched. The port reads per scan are reported: one per driver line with CHKB4_SHARED_PORT.
+
+    The table driven scan (without CHKB4_SHARED_PORT) can't be run here: its table takes the pin registers'
+    addresses, and the model needs a function call on every PIND read.
+*/
+
+#include "host.h"
+#include "avr/io.h"
+#include "../../src/chkb4.h"
+
+#define KEYS (CHKB4_LINES * (CHKB4_LINES - 1))
+#define LINES_MASK (((1 << CHKB4_LINES) - 1) << CHKB4_LINE_0_BIT)
+
+// the other bits of the port, kept across the scan
+#define OTHER_PORT 0x05
+#define OTHER_PDIR 0x0a
+
+chkb4_keys_t chkb4_scan(void);
+
+unsigned long scans;
+
+void scan(uint32_t keys)
+{
+  chkb4_keys_t found;
+
+  host_keys = keys;
+  found = chkb4_scan();
+  scans++;
+
+  host_check(found == keys, "keys %05lx found as %05lx", (unsigned long)keys, (unsigned long)found);
+  host_check((DDRD & LINES_MASK) == 0 && (PORTD & LINES_MASK) == LINES_MASK,
+    "keys %05lx: lines left as DDRD %02x PORTD %02x", (unsigned long)keys, DDRD, PORTD);
+  host_check((DDRD & ~LINES_MASK) == OTHER_PDIR && (PORTD & ~LINES_MASK) == OTHER_PORT,
+    "keys %05lx: other bits changed to DDRD %02x PORTD %02x", (unsigned long)keys, DDRD, PORTD);
+}
+
+int main(void)
+{
+  unsigned a, b;
+
+  PORTD = OTHER_PORT;
+  DDRD = OTHER_PDIR;
+  chkb4_init();
+
+  scan(0);
+  for(a = 0; a < KEYS; a++)
+  {
+    scan(1UL << a);
+    for(b = a + 1; b < KEYS; b++) scan((1UL << a) | (1UL << b));
+  }
+
+  host_check(host_pind_reads == scans * CHKB4_LINES, "%lu port reads in %lu scans", host_pind_reads, scans);
+  printf("%d lines, %d keys: %lu scans, %lu port reads per scan\n",
+    CHKB4_LINES, KEYS, scans, host_pind_reads / scans);
+
+  return host_result("chkb4_scan");
+}
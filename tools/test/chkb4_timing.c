@@ -0,0 +1,196 @@
+/*
+    chkb4 long press, auto-repeat and repeat acceleration, on the keyboard model.
+
+    chkb4_update() is run as by the timer interrupt, one run per CHKB4_PERIOD_US of virtual time,
+    with keys held and released on the keyboard model. Every event must come at its run:
+    the press CHKB4_DEBOUNCE runs after the contact closes, the long press CHKB4_LONG_DELAY runs
+    and the first repeat CHKB4_REPEAT_DELAY runs after the press, then a repeat every CHKB4_REPEAT_PERIOD runs.
+
+    Keypress to target: a tuning key is held until chkb4_accel() has summed the channels to a target,
+    as action_tune_up() does, and released. The time to get there is reported for each target.
+*/
+
+#include "host.h"
+#include "../../src/chkb4.h"
+
+#define RUN_MS(runs) ((unsigned long)(runs) * CHKB4_PERIOD_US / 1000)
+
+// Events taken out of the queue after every run, with the run they were taken at.
+#define LOG_SIZE 256
+
+struct chkb4_event log_event[LOG_SIZE];
+unsigned log_count;
+
+void run(unsigned runs)
+{
+  while(runs--)
+  {
+    chkb4_update();
+    while(log_count < LOG_SIZE && chkb4_get_event(&log_event[log_count])) log_count++;
+  }
+}
+
+// Index of the next logged event of a type from 'from' on, log_count if none.
+unsigned find(unsigned from, uint8_t type)
+{
+  while(from < log_count && log_event[from].type != type) from++;
+  return from;
+}
+
+unsigned count(uint8_t type)
+{
+  unsigned i, n = 0;
+
+  for(i = 0; i < log_count; i++) if(log_event[i].type == type) n++;
+  return n;
+}
+
+void reset(void)
+{
+  host_keys = 0;
+  run(CHKB4_DEBOUNCE + 1);
+  log_count = 0;
+}
+
+
+
+
+/*
+    Short press: press, release, short, nothing else.
+*/
+
+void short_press(void)
+{
+  uint16_t start;
+
+  reset();
+  start = chkb4_time;
+  host_keys = 1UL << KEY_04;
+  run(CHKB4_REPEAT_DELAY / 2);
+  host_keys = 0;
+  run(CHKB4_DEBOUNCE + 1);
+
+  host_check(log_count == 3, "short press: %u events", log_count);
+  host_check(log_event[0].type == CHKB4_PRESS && log_event[0].key == KEY_04, "short press: no press first");
+  host_check((uint16_t)(log_event[0].time - start) == CHKB4_DEBOUNCE, "short press: press after %u runs",
+    (uint16_t)(log_event[0].time - start));
+  host_check(log_event[1].type == CHKB4_RELEASE && log_event[2].type == CHKB4_SHORT, "short press: no release, short");
+}
+
+
+
+
+/*
+    Long hold: long press and repeats at their runs, no short.
+*/
+
+#define HOLD_RUNS (CHKB4_REPEAT_DELAY + 10 * CHKB4_REPEAT_PERIOD)
+
+void long_hold(void)
+{
+  unsigned i, n;
+  uint16_t press;
+
+  reset();
+  host_keys = 1UL << KEY_04;
+  run(CHKB4_DEBOUNCE + HOLD_RUNS);
+  host_keys = 0;
+  run(CHKB4_DEBOUNCE + 1);
+
+  host_check(log_count && log_event[0].type == CHKB4_PRESS, "long hold: no press first");
+  press = log_event[0].time;
+
+  i = find(0, CHKB4_LONG);
+  host_check(count(CHKB4_LONG) == 1, "long hold: %u long presses", count(CHKB4_LONG));
+  host_check(i < log_count && (uint16_t)(log_event[i].time - press) == CHKB4_LONG_DELAY,
+    "long hold: long press after %u runs", i < log_count ? (uint16_t)(log_event[i].time - press) : 0);
+
+  for(n = 0, i = find(0, CHKB4_REPEAT); i < log_count; n++, i = find(i + 1, CHKB4_REPEAT))
+    host_check((uint16_t)(log_event[i].time - press) == CHKB4_REPEAT_DELAY + n * CHKB4_REPEAT_PERIOD,
+      "long hold: repeat %u after %u runs", n, (uint16_t)(log_event[i].time - press));
+  host_check(n == 11, "long hold: %u repeats", n);
+
+  host_check(count(CHKB4_SHORT) == 0, "long hold: short press after a long one");
+  host_check(log_event[log_count - 1].type == CHKB4_RELEASE, "long hold: no release last");
+}
+
+
+
+
+/*
+    Chord: a second key pressed while the first is held gets a chord event and takes over the repeats.
+*/
+
+void chord(void)
+{
+  unsigned i;
+
+  reset();
+  host_keys = 1UL << KEY_04;
+  run(CHKB4_DEBOUNCE + CHKB4_REPEAT_DELAY / 2);
+  host_keys |= 1UL << KEY_05;
+  run(CHKB4_DEBOUNCE + CHKB4_REPEAT_DELAY + 1);
+
+  i = find(0, CHKB4_CHORD);
+  host_check(i < log_count && log_event[i].key == KEY_05 && log_event[i - 1].type == CHKB4_PRESS,
+    "chord: no chord event after the second press");
+  for(i = find(0, CHKB4_REPEAT); i < log_count; i = find(i + 1, CHKB4_REPEAT))
+    host_check(log_event[i].key == KEY_05, "chord: repeat of key %u", log_event[i].key);
+  host_check(count(CHKB4_REPEAT) == 1, "chord: %u repeats", count(CHKB4_REPEAT));
+}
+
+
+
+
+/*
+    Keypress to target
+*/
+
+const unsigned target_channels[] = { 1, 10, 50, 100, 200, 410, 1000, 4000 };
+
+#define TARGET_MAX_RUNS 2000
+
+void keypress_to_target(void)
+{
+  unsigned t, i, channels, step = 0, runs;
+  unsigned long last_ms = 0;
+
+  printf("%8s %8s %8s %10s\n", "channels", "time ms", "repeats", "last step");
+  for(t = 0; t < sizeof(target_channels) / sizeof(target_channels[0]); t++)
+  {
+    reset();
+    host_keys = 1UL << KEY_04;
+    for(channels = 0, runs = 0, i = 0; channels < target_channels[t] && runs < TARGET_MAX_RUNS; runs++)
+    {
+      run(1);
+      for(; i < log_count; i++)
+        if(log_event[i].type == CHKB4_PRESS || log_event[i].type == CHKB4_REPEAT)
+          channels += step = chkb4_accel(&log_event[i]);
+    }
+    host_keys = 0;
+
+    host_check(channels >= target_channels[t], "target %u: %u channels after %lu ms",
+      target_channels[t], channels, RUN_MS(runs));
+    host_check(channels - target_channels[t] < step, "target %u: %u channels over",
+      target_channels[t], channels - target_channels[t]);
+    host_check(RUN_MS(runs) >= last_ms, "target %u: faster than a smaller one", target_channels[t]);
+    last_ms = RUN_MS(runs);
+
+    printf("%8u %8lu %8u %10u\n", target_channels[t], last_ms, count(CHKB4_REPEAT), step);
+  }
+}
+
+
+
+
+int main(void)
+{
+  chkb4_init();
+
+  short_press();
+  long_hold();
+  chord();
+  keypress_to_target();
+
+  return host_result("chkb4_timing");
+}
@@ -0,0 +1,243 @@
+/*
+    chkb4 wake up from idle mode, on the keyboard model, through main.c's idle sequence.
+
+    The main loop is modelled pass by pass, PASSES passes per timer 0 overflow (a run of chkb4_update()).
+    Every pass takes the queued events, as the keys task does, then goes through idle():
+    when chkb4_idle() is true it arms the wake up and sleeps. A sleeping MCU runs nothing until
+    a pin of the wake up mask changes, which calls the wake up interrupt; idle() then disarms the wake up
+    and restarts timer 0 from 0, a whole run away from the next chkb4_update().
+
+    A wake key (KEY_09 - KEY_11) is pressed while the MCU sleeps, with contact bounce, held, and released.
+    Its press, short (or, bouncing long enough, long) press and release must all be queued, and the MCU must be back asleep after the release.
+    A key that can't wake the MCU (KEY_04) must leave it asleep, without events.
+    The latency from the first touch of the contact to the press event is reported.
+
+    The bounce patterns are pseudo-random from a fixed seed, so a run is reproducible.
+*/
+
+#include "host.h"
+#include "avr/io.h"
+#include "avr/interrupt.h"
+#include "../../src/chkb4.h"
+
+#define TRIALS 2000
+#define PASSES 64
+#define BOUNCES_MAX 4
+#define HOLD_MIN (CHKB4_DEBOUNCE + 1)
+#define HOLD_MAX (CHKB4_LONG_DELAY - 1)
+#define WAIT_MAX 50
+
+void pcint2_vect(void);
+
+// xorshift
+uint32_t random_state = 2463534242UL;
+
+uint32_t random_next(void)
+{
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+unsigned random_range(unsigned low, unsigned high)
+{
+  return low + random_next() % (high - low + 1);
+}
+
+
+
+
+/*
+    MCU
+
+    'asleep' while in power down, with 'armed_pins' the level of the wake up pins when it went to sleep.
+    'pass' counts the passes since the last timer 0 overflow.
+*/
+
+uint8_t asleep, armed_pins;
+unsigned pass;
+unsigned long sleeps, wakes;
+
+// events taken by the keys task, per type.
+unsigned events[CHKB4_EVENT_TYPES];
+
+// runs of wall time, going on while asleep, and the run the last press event was taken in.
+unsigned long wall, press_wall;
+
+void idle(void)
+{
+  if(!chkb4_idle()) return;
+  chkb4_wake_arm();
+  armed_pins = *host_pind() & PCMSK2;
+  asleep = 1;
+  sleeps++;
+}
+
+void wake(void)
+{
+  pcint2_vect();
+  asleep = 0;
+  wakes++;
+  chkb4_wake_disarm();
+  pass = 0;
+}
+
+// One main loop pass, or a look at the wake up pins while asleep.
+void step(void)
+{
+  struct chkb4_event event;
+
+  if(asleep)
+  {
+    if((*host_pind() & PCMSK2) != armed_pins) wake();
+    return;
+  }
+  if(++pass == PASSES)
+  {
+    pass = 0;
+    chkb4_update();
+  }
+  while(chkb4_get_event(&event))
+  {
+    events[event.type]++;
+    if(event.type == CHKB4_PRESS) press_wall = wall;
+  }
+  idle();
+}
+
+// Runs 'runs' runs of wall time, the contact of 'key' closed for the runs 'closed' tells.
+void run(uint8_t key, unsigned runs, uint8_t (*closed)(unsigned run))
+{
+  unsigned r, p;
+
+  for(r = 0; r < runs; r++)
+  {
+    host_keys = closed && closed(r) ? 1UL << key : 0;
+    for(p = 0; p < PASSES; p++) step();
+    wall++;
+  }
+}
+
+
+
+
+/*
+    Contact
+
+    Levels of a press: bounce segments of alternating levels, closed first, then closed for the hold,
+    then bounce segments of alternating levels, open first, then open.
+*/
+
+#define SEGMENTS_MAX (2 * BOUNCES_MAX + 3)
+
+unsigned segment_end[SEGMENTS_MAX];
+uint8_t segment_closed[SEGMENTS_MAX];
+unsigned segments, contact_runs;
+
+void contact_plan(void)
+{
+  unsigned i, bounces, end = 0;
+
+  segments = 0;
+  for(bounces = 2 * random_range(0, BOUNCES_MAX / 2), i = 0; i < bounces; i++)
+  {
+    segment_closed[segments] = !(i & 1);
+    segment_end[segments++] = end += random_range(1, CHKB4_DEBOUNCE - 1);
+  }
+  segment_closed[segments] = 1;
+  segment_end[segments++] = end += random_range(HOLD_MIN, HOLD_MAX);
+  for(bounces = 2 * random_range(0, BOUNCES_MAX / 2), i = 0; i < bounces; i++)
+  {
+    segment_closed[segments] = i & 1;
+    segment_end[segments++] = end += random_range(1, CHKB4_DEBOUNCE - 1);
+  }
+  contact_runs = end;
+}
+
+uint8_t contact_closed(unsigned run)
+{
+  unsigned i;
+
+  for(i = 0; i < segments; i++) if(run < segment_end[i]) return segment_closed[i];
+  return 0;
+}
+
+uint8_t always_closed(unsigned run)
+{
+  return 1;
+}
+
+
+
+
+/*
+    Trials
+*/
+
+void clear_events(void)
+{
+  unsigned i;
+
+  for(i = 0; i < CHKB4_EVENT_TYPES; i++) events[i] = 0;
+}
+
+void wake_keys(void)
+{
+  const uint8_t keys[] = { KEY_09, KEY_10, KEY_11 };
+  unsigned trial;
+  unsigned long touch, latency, latency_max = 0, latency_sum = 0;
+  uint8_t key;
+
+  for(trial = 0; trial < TRIALS; trial++)
+  {
+    key = keys[random_next() % sizeof(keys)];
+    run(key, 1 + random_range(0, WAIT_MAX), 0);
+    host_check(asleep, "trial %u: awake before the press", trial);
+
+    clear_events();
+    contact_plan();
+    touch = wall;
+    run(key, contact_runs + 2 * CHKB4_DEBOUNCE + 2, contact_closed);
+
+    host_check(events[CHKB4_PRESS] == 1 && events[CHKB4_SHORT] + events[CHKB4_LONG] == 1 && events[CHKB4_RELEASE] == 1,
+      "trial %u: key %u gave %u presses, %u short and %u long presses, %u releases", trial, key,
+      events[CHKB4_PRESS], events[CHKB4_SHORT], events[CHKB4_LONG], events[CHKB4_RELEASE]);
+    host_check(asleep, "trial %u: awake after the release", trial);
+    if(host_failures > 10) return;
+
+    latency = press_wall - touch + 1;
+    latency_sum += latency;
+    if(latency > latency_max) latency_max = latency;
+  }
+  printf("%u wake presses, %lu sleeps, %lu wake ups, touch to press event %.1f ms on average, %.1f ms at most\n",
+    TRIALS, sleeps, wakes, (double)latency_sum / TRIALS * CHKB4_PERIOD_US / 1000,
+    (double)latency_max * CHKB4_PERIOD_US / 1000);
+}
+
+void other_key(void)
+{
+  unsigned long woken = wakes;
+
+  run(KEY_04, 10, 0);
+  clear_events();
+  run(KEY_04, 2 * CHKB4_DEBOUNCE + 2, always_closed);
+  host_check(asleep && wakes == woken, "KEY_04 woke the MCU up");
+  host_check(!events[CHKB4_PRESS], "KEY_04 pressed while asleep");
+  run(KEY_04, 10, 0);
+}
+
+
+
+
+int main(void)
+{
+  chkb4_init();
+  idle();
+  host_check(asleep, "not asleep with the keyboard idle");
+
+  wake_keys();
+  other_key();
+
+  return host_result("chkb4_wake");
+}
@@ -0,0 +1,224 @@
+/*
+    Encoder driver on a simulated quadrature waveform, in virtual time.
+
+    The encoder is turned in bursts of random detents, direction and speed, with pauses between them.
+    Every quarter step changes one line and runs the pin change interrupt. Half the edges bounce: the line toggles
+    back and forth a few times, each toggle running the interrupt too. The main loop reads the encoder
+    every ENCODER_PERIOD_MS, as task_encoder() does.
+
+    Without missed interrupts every detent turned must be read, and the latency from the detent's last edge
+    to the read that takes it is reported. Then 1 edge in MISS_ODDS gets no interrupt of its own, so that
+    the next one sees both lines changed: each of these must be counted in 'encoder_errors',
+    and the detents lost with them are reported.
+
+    The waveforms are pseudo-random from a fixed seed, so a run is reproducible.
+*/
+
+#include "host.h"
+#include "avr/io.h"
+#include "avr/interrupt.h"
+#include "../../src/encoder.h"
+
+#define BURSTS 2000
+#define BURST_DETENTS_MAX 20
+#define DETENT_US_MIN 2000
+#define DETENT_US_MAX 100000
+#define PAUSE_US (3 * ENCODER_PERIOD_MS * 1000UL)
+#define BOUNCE_US 50
+#define MISS_ODDS 100
+
+void pcint0_vect(void);
+extern volatile int8_t encoder_detents;
+
+// xorshift
+uint32_t random_state = 2463534242UL;
+
+uint32_t random_next(void)
+{
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+unsigned long random_range(unsigned long low, unsigned long high)
+{
+  return low + random_next() % (high - low + 1);
+}
+
+
+
+
+/*
+    Virtual time and the main loop's reads
+
+    The detents made by the interrupt are queued with their time, and taken off by the reads for the latency.
+*/
+
+unsigned long now_us, next_read_us;
+
+#define DETENT_QUEUE 256
+
+unsigned long detent_us[DETENT_QUEUE];
+unsigned detent_head, detent_tail;
+
+long turned, read;
+unsigned long turned_total, read_total;
+unsigned long latency_sum, latency_max, latency_count;
+
+void advance(unsigned long us)
+{
+  int8_t detents;
+  unsigned n;
+
+  now_us += us;
+  while(next_read_us <= now_us)
+  {
+    detents = encoder_read();
+    read += detents;
+    read_total += detents < 0 ? -detents : detents;
+    for(n = detents < 0 ? -detents : detents; n && detent_tail != detent_head; n--)
+    {
+      unsigned long latency = next_read_us - detent_us[detent_tail++ % DETENT_QUEUE];
+      latency_sum += latency;
+      latency_count++;
+      if(latency > latency_max) latency_max = latency;
+    }
+    next_read_us += ENCODER_PERIOD_MS * 1000UL;
+  }
+}
+
+void interrupt(void)
+{
+  int8_t detents = encoder_detents;
+
+  pcint0_vect();
+  if(encoder_detents != detents) detent_us[detent_head++ % DETENT_QUEUE] = now_us;
+}
+
+
+
+
+/*
+    Waveform
+
+    'lines' is the encoder's state as seen by encoder_lines(), A in bit 0 and B in bit 1, 1 for a closed contact.
+    Turning up goes 00, 01, 11, 10.
+*/
+
+const uint8_t gray[4] = { 0, 1, 3, 2 };
+
+uint8_t phase, misses, miss_odds, missed;
+
+void set_lines(uint8_t lines)
+{
+  PINB = (PINB | (1 << ENCODER_A_BIT) | (1 << ENCODER_B_BIT))
+    & ~(((lines & 1) << ENCODER_A_BIT) | (((lines >> 1) & 1) << ENCODER_B_BIT));
+}
+
+// 'last' is set for a burst's last quarter, which is never missed: the next burst may turn back.
+void quarter(int8_t dir, unsigned long us, uint8_t last)
+{
+  uint8_t old = gray[phase], new, bounces;
+
+  phase = (phase + dir) & 3;
+  new = gray[phase];
+  set_lines(new);
+
+  if(miss_odds && !missed && !last && random_next() % miss_odds == 0)
+  {
+    // no interrupt for this edge: the next edge's interrupt sees both lines changed
+    misses++;
+    missed = 1;
+    advance(us);
+    return;
+  }
+
+  missed = 0;
+  interrupt();
+  for(bounces = random_next() % 2 ? random_range(1, 3) : 0; bounces; bounces--)
+  {
+    advance(BOUNCE_US);
+    set_lines(old);
+    interrupt();
+    advance(BOUNCE_US);
+    set_lines(new);
+    interrupt();
+    us -= 2 * BOUNCE_US;
+  }
+  advance(us);
+}
+
+void bursts(unsigned count)
+{
+  unsigned detents, n;
+  int8_t dir;
+  unsigned long quarter_us;
+
+  while(count--)
+  {
+    dir = random_next() % 2 ? 1 : -1;
+    detents = random_range(1, BURST_DETENTS_MAX);
+    quarter_us = random_range(DETENT_US_MIN, DETENT_US_MAX) / ENCODER_STEPS;
+    for(n = 0; n < detents * ENCODER_STEPS; n++) quarter(dir, quarter_us, n == detents * ENCODER_STEPS - 1);
+    turned += dir * (long)detents;
+    turned_total += detents;
+    advance(PAUSE_US);
+  }
+}
+
+
+
+
+/*
+    Velocity scaling: one channel per detent when slow, more when fast, never fewer for faster turning.
+*/
+
+void scaling(void)
+{
+  int16_t d, last = 0, steps;
+
+  host_check(encoder_steps(0) == 0 && encoder_steps(1) == 1 && encoder_steps(-1) == -1, "slow turning scaled");
+  for(d = 1; d <= 127; d++)
+  {
+    steps = encoder_steps(d);
+    host_check(steps >= last && steps >= d, "%d detents: %d channels", d, steps);
+    host_check(encoder_steps(-d) == -steps, "%d detents: %d channels", -d, encoder_steps(-d));
+    last = steps;
+  }
+}
+
+
+
+
+int main(void)
+{
+  unsigned n;
+
+  PINB = 0xff;
+  encoder_init();
+  scaling();
+
+  bursts(BURSTS);
+  host_check(read == turned, "%ld detents turned, %ld read", turned, read);
+  host_check(encoder_errors == 0, "%u errors without missed interrupts", encoder_errors);
+  printf("%lu detents, latency to the read %lu us mean, %lu us max\n", turned_total,
+    latency_sum / latency_count, latency_max);
+  host_check(latency_max <= ENCODER_PERIOD_MS * 1000UL, "latency over a read period");
+
+  turned = read = 0;
+  turned_total = read_total = 0;
+  miss_odds = MISS_ODDS;
+  bursts(BURSTS / 10);
+  host_check(encoder_errors == misses, "%u missed interrupts, %u errors", misses, encoder_errors);
+  printf("%u missed interrupts: %lu detents turned, %lu read\n", misses, turned_total, read_total);
+
+  // saturation: the detents turned between two reads are all taken, up to 127
+  miss_odds = 0;
+  next_read_us = -1UL;
+  encoder_read();
+  for(n = 0; n < 200 * ENCODER_STEPS; n++) quarter(1, 100, 0);
+  host_check(encoder_read() == 127, "200 detents not read as 127");
+
+  return host_result("encoder_wave");
+}
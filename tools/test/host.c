@@ -0,0 +1,69 @@
+/*
+    Host test support.
+*/
+
+#include "host.h"
+#include "avr/io.h"
+#include "../../src/chkb4.h"
+
+
+
+
+/*
+    Registers
+*/
+
+volatile uint8_t PORTB, DDRB, PINB = 0xff, PORTC, DDRC, PINC = 0xff, PORTD, DDRD;
+volatile uint8_t PCMSK0, PCMSK1, PCMSK2, PCIFR, PCICR, TCNT0, TIFR0, SREG;
+volatile uint8_t UCSR0A, UCSR0B, UCSR0C, UDR0;
+volatile uint16_t UBRR0;
+
+
+
+
+/*
+    Keyboard model
+
+    The lines are on PORTD from CHKB4_LINE_0_BIT up, with pull-ups. Key 'k' connects driver line
+    k / (N - 1) to sense line k % (N - 1), skipping the driver itself, through a diode:
+    a held key pulls its sense line low while its driver line is an output driven low.
+*/
+
+uint32_t host_keys;
+unsigned long host_pind_reads;
+uint8_t host_pind_value;
+
+volatile uint8_t *host_pind(void)
+{
+  uint8_t pins = 0xff, driver, sense, key;
+
+  for(key = 0; key < CHKB4_LINES * (CHKB4_LINES - 1); key++)
+  {
+    if(!(host_keys & (1UL << key))) continue;
+    driver = key / (CHKB4_LINES - 1);
+    sense = key % (CHKB4_LINES - 1);
+    if(sense >= driver) sense++;
+    if((DDRD & ~PORTD) & (1 << (CHKB4_LINE_0_BIT + driver))) pins &= ~(1 << (CHKB4_LINE_0_BIT + sense));
+  }
+  // an output reads its own level
+  pins = (pins & ~DDRD) | (PORTD & DDRD);
+
+  host_pind_reads++;
+  host_pind_value = pins;
+  return &host_pind_value;
+}
+
+
+
+
+/*
+    Results
+*/
+
+unsigned host_failures;
+
+int host_result(const char *test)
+{
+  printf("%s: %s\n", test, host_failures ? "FAILED" : "passed");
+  return host_failures ? 1 : 0;
+}
@@ -0,0 +1,25 @@
+/*
+    Host test support: the registers of the host stand-in <avr/io.h>, and a model of the charlieplexed keyboard.
+*/
+
+#ifndef __HOST__
+#define __HOST__
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Keys held down on the keyboard model, a bit per key as in chkb4's registers.
+extern uint32_t host_keys;
+
+// Reads of PIND so far.
+extern unsigned long host_pind_reads;
+
+// Counts a failed check and reports it.
+extern unsigned host_failures;
+#define host_check(condition, ...) \
+  do { if(!(condition)) { host_failures++; printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while(0)
+
+// Prints the test's result, returns the exit status.
+int host_result(const char *test);
+
+#endif
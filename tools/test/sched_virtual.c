@@ -0,0 +1,195 @@
+/*
+    Scheduler in virtual time.
+
+    The tick timer is virtual: its counter TCNT0 moves only when a task or the main loop spends time,
+    and every overflow calls sched_tick(), as the timer interrupt does. The tasks are those of main.c,
+    with their periods and deadlines, each spending a fixed run time. The main loop calls sched_run()
+    over and over, each pass spending LOOP_COUNTS.
+
+    With light tasks, every periodic task must run on time, every period, without a miss.
+    With a slow display task, the tasks after it must be late by up to its run time, the misses must be counted,
+    and a periodic task falling behind must skip its missed runs. A one-shot task must run once, on time.
+    Every run's time must be measured exactly. The tick count starts just before it wraps.
+    The statistics of the loaded case are reported.
+*/
+
+#include "host.h"
+#include "avr/io.h"
+#include "../../src/sched.h"
+
+#define LOOP_COUNTS 1
+#define TICKS 10000
+#define TICK_COUNTS 256
+
+extern volatile uint16_t sched_ticks;
+
+void spend(uint16_t counts)
+{
+  counts += TCNT0;
+  while(counts >= TICK_COUNTS) { sched_tick(); counts -= TICK_COUNTS; }
+  TCNT0 = counts;
+}
+
+
+
+
+/*
+    Tasks, as in main.c, spending 'cost[task]' timer counts (SCHED_CLOCK_US each) per run.
+*/
+
+#define ENCODER_PERIOD_MS 50
+
+enum { TASK_KEYS, TASK_TIMERS, TASK_ENCODER, TASK_TUNE, TASK_SCAN, TASK_METERS, TASK_RDS, TASK_STATUS, TASKS };
+
+const char *task_name[TASKS] = { "keys", "timers", "encoder", "tune", "scan", "meters", "rds", "status" };
+
+uint16_t cost[TASKS];
+unsigned long runs[TASKS];
+uint16_t last_run[TASKS];
+
+#define TASK(n) void task_##n(void) { runs[n]++; last_run[n] = sched_ticks; spend(cost[n]); }
+
+TASK(TASK_KEYS) TASK(TASK_TIMERS) TASK(TASK_ENCODER) TASK(TASK_TUNE)
+TASK(TASK_SCAN) TASK(TASK_METERS) TASK(TASK_RDS) TASK(TASK_STATUS)
+
+struct sched_task tasks[TASKS];
+
+const struct sched_task task_setup[TASKS] = {
+  [TASK_KEYS] = { task_TASK_KEYS, 1, 1 },
+  [TASK_TIMERS] = { task_TASK_TIMERS, 1, 1 },
+  [TASK_ENCODER] = { task_TASK_ENCODER, SCHED_MS(ENCODER_PERIOD_MS), 2 },
+  [TASK_TUNE] = { task_TASK_TUNE, 0, 2 },
+  [TASK_SCAN] = { task_TASK_SCAN, 0, 2 },
+  [TASK_METERS] = { task_TASK_METERS, SCHED_MS(100), SCHED_MS(100) / 2 },
+  [TASK_RDS] = { task_TASK_RDS, SCHED_MS(80), SCHED_MS(80) },
+  [TASK_STATUS] = { task_TASK_STATUS, SCHED_MS(500), SCHED_MS(500) / 2 },
+};
+
+void setup(const uint16_t *costs)
+{
+  uint8_t i;
+
+  sched_ticks = 0x10000 - TICKS / 2;
+  TCNT0 = 0;
+  for(i = 0; i < TASKS; i++)
+  {
+    tasks[i] = task_setup[i];
+    cost[i] = costs[i];
+    runs[i] = 0;
+  }
+  sched_init(tasks, TASKS);
+}
+
+void run(unsigned long ticks)
+{
+  uint16_t end = sched_ticks + ticks;
+
+  while((int16_t)(sched_ticks - end) < 0)
+  {
+    sched_run();
+    spend(LOOP_COUNTS);
+  }
+}
+
+
+
+
+/*
+    Light load: a few hundred microseconds per task.
+*/
+
+const uint16_t light_costs[TASKS] = { 3, 2, 2, 20, 20, 60, 30, 100 };
+
+void light(void)
+{
+  uint8_t i;
+
+  setup(light_costs);
+  run(TICKS);
+
+  for(i = 0; i < TASKS; i++)
+  {
+    if(!tasks[i].period) continue;
+    host_check(runs[i] == TICKS / tasks[i].period || runs[i] == TICKS / tasks[i].period + 1,
+      "light: %s ran %lu times in %u ticks", task_name[i], runs[i], TICKS);
+    host_check(tasks[i].late_max <= 1 && tasks[i].misses == 0,
+      "light: %s late by %u ticks, %u misses", task_name[i], tasks[i].late_max, tasks[i].misses);
+    host_check(tasks[i].run_max == cost[i], "light: %s run measured %u counts", task_name[i], tasks[i].run_max);
+  }
+}
+
+
+
+
+/*
+    One-shot: runs once, 'delay' ticks after the wake, unless stopped.
+*/
+
+void one_shot(void)
+{
+  uint16_t woken;
+
+  setup(light_costs);
+  run(10);
+  woken = sched_ticks;
+  sched_wake(TASK_TUNE, 7);
+  run(20);
+  host_check(runs[TASK_TUNE] == 1, "one-shot: ran %lu times", runs[TASK_TUNE]);
+  host_check((uint16_t)(last_run[TASK_TUNE] - woken) == 7, "one-shot: ran %u ticks after the wake",
+    (uint16_t)(last_run[TASK_TUNE] - woken));
+
+  sched_wake(TASK_SCAN, 5);
+  run(2);
+  sched_stop(TASK_SCAN);
+  run(10);
+  host_check(runs[TASK_SCAN] == 0, "one-shot: stopped task ran");
+}
+
+
+
+
+/*
+    Heavy load: a full display redraw of about 40ms in the status task.
+*/
+
+const uint16_t heavy_costs[TASKS] = { 3, 2, 2, 20, 20, 60, 30, 1280 };
+
+void heavy(void)
+{
+  uint8_t i;
+  uint16_t status_ticks = (heavy_costs[TASK_STATUS] + TICK_COUNTS - 1) / TICK_COUNTS;
+
+  setup(heavy_costs);
+  run(TICKS);
+
+  printf("%-8s %6s %6s %8s %8s %8s\n", "task", "period", "runs", "late ms", "misses", "run us");
+  for(i = 0; i < TASKS; i++)
+  {
+    printf("%-8s %6u %6lu %8lu %8u %8lu\n", task_name[i], tasks[i].period, runs[i],
+      tasks[i].late_max * SCHED_TICK_US / 1000, tasks[i].misses, tasks[i].run_max * SCHED_CLOCK_US);
+    if(!tasks[i].period) continue;
+    host_check(runs[i] <= TICKS / tasks[i].period + 1, "heavy: %s ran %lu times, catching up", task_name[i], runs[i]);
+    // each status run skips the runs due while it runs
+    host_check(runs[i] + runs[TASK_STATUS] * (status_ticks / tasks[i].period + 1) >= TICKS / tasks[i].period,
+      "heavy: %s ran %lu times", task_name[i], runs[i]);
+    host_check(tasks[i].late_max <= status_ticks + 1, "heavy: %s late by %u ticks", task_name[i], tasks[i].late_max);
+  }
+  // keys ran in the tick the status run started in, and was due in the next one.
+  host_check(tasks[TASK_KEYS].late_max >= status_ticks - 2, "heavy: keys late by only %u ticks",
+    tasks[TASK_KEYS].late_max);
+  host_check(tasks[TASK_KEYS].misses > 0, "heavy: no keys deadline missed");
+  host_check(tasks[TASK_STATUS].run_max == heavy_costs[TASK_STATUS], "heavy: status run measured %u counts",
+    tasks[TASK_STATUS].run_max);
+}
+
+
+
+
+int main(void)
+{
+  light();
+  one_shot();
+  heavy();
+
+  return host_result("sched_virtual");
+}
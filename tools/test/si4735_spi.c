@@ -0,0 +1,381 @@
+/*
+    Si4735 SPI byte routines replayed cycle by cycle against a model of the Si4735, at F_CPU.
+
+    The assembly of si4735_spi_send_byte() and si4735_spi_receive_byte() is built from the macros
+    of si4735_spi.h, exactly as in si4735.c, with the operands the routines give it. It is interpreted
+    with the AVR's instruction timings: 'sbi' and 'cbi' write the port at the end of their 2 cycles,
+    a skip takes 1 cycle more when it skips, and 'sbic' reads the pin through the input synchroniser,
+    which shows a pin change 0.5 to 1.5 cycles after it: the pin must be stable over that window.
+
+    The Si4735 samples SDIO at SCLK's rising edge, with SDIO_SETUP_NS setup and SDIO_HOLD_NS hold time.
+    When the MCU receives, the Si4735 drives the next bit from SCLK's falling edge, valid SI4735_SDIO_VALID_NS later,
+    SDIO being undefined in between. Every byte value is sent and received,
+    each routine starting right after the previous SCLK falling edge. SCLK's high and low times must
+    be at least SI4735_SCLK_HALF_NS. The cycles per bit and the SCLK frequency are reported.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include "host.h"
+#include "avr/io.h"
+#include "../../src/si4735.h"
+#include "../../src/si4735_spi.h"
+
+#define SDIO_SETUP_NS 15
+#define SDIO_HOLD_NS 10
+
+#define CYCLE_NS (1e9 / F_CPU)
+
+// I/O addresses of the registers the Si4735 lines are on.
+#define PINB_ADDRESS 0x03
+#define PORTB_ADDRESS 0x05
+
+unsigned io_address(volatile uint8_t *reg)
+{
+  if(reg == &PINB) return PINB_ADDRESS;
+  if(reg == &PORTB) return PORTB_ADDRESS;
+  printf("FAIL: Si4735 line off port B\n");
+  exit(1);
+}
+
+
+
+
+/*
+    Programs, as built in si4735.c.
+*/
+
+const char send_program[] =
+  SI4735_ASM_SEND_BIT( 7 ) SI4735_ASM_SEND_BIT( 6 ) SI4735_ASM_SEND_BIT( 5 ) SI4735_ASM_SEND_BIT( 4 )
+  SI4735_ASM_SEND_BIT( 3 ) SI4735_ASM_SEND_BIT( 2 ) SI4735_ASM_SEND_BIT( 1 ) SI4735_ASM_SEND_BIT( 0 );
+
+const char receive_program[] =
+  SI4735_ASM_RECEIVE_BIT( 7 ) SI4735_ASM_RECEIVE_BIT( 6 ) SI4735_ASM_RECEIVE_BIT( 5 ) SI4735_ASM_RECEIVE_BIT( 4 )
+  SI4735_ASM_RECEIVE_BIT( 3 ) SI4735_ASM_RECEIVE_BIT( 2 ) SI4735_ASM_RECEIVE_BIT( 1 ) SI4735_ASM_RECEIVE_BIT( 0 );
+
+struct operand
+{
+  const char *name;
+  long value;
+};
+
+struct operand operands[8];
+
+void set_operands(void)
+{
+  struct operand table[] = {
+    { "sclk_port", io_address(&SI4735_SCLKPORT) }, { "sclk_bit", si4735_bitnum( SI4735_SCLKBIT ) },
+    { "pad", SI4735_SCLK_PAD },
+    { "sdio_port", io_address(&SI4735_SDIOPORT) }, { "sdio_pin", io_address(&SI4735_SDIOPIN) },
+    { "sdio_bit", si4735_bitnum( SI4735_SDIOBIT ) },
+    { "settle", SI4735_SDIO_SETTLE },
+    { 0 }
+  };
+
+  memcpy(operands, table, sizeof(table));
+}
+
+
+
+
+/*
+    Assembler
+
+    Handles the instructions and directives the macros use, '.rept' not nested.
+*/
+
+enum { NOP, SBI, CBI, SBIC, SBRC, SBRS, ORI };
+
+const char *mnemonics[] = { "nop", "sbi", "cbi", "sbic", "sbrc", "sbrs", "ori", 0 };
+
+struct instruction
+{
+  uint8_t op;
+  long a, b;    // operands, 'byte' as -1
+};
+
+#define CODE_SIZE 1024
+
+struct instruction code[CODE_SIZE];
+unsigned code_size;
+
+// an operand: %[name], a number or 'number << number'.
+long operand(const char *text)
+{
+  struct operand *o;
+  char *end;
+  long value;
+
+  while(*text == ' ') text++;
+  if(!strncmp(text, "%[", 2))
+  {
+    if(!strncmp(text + 2, "byte]", 5)) return -1;
+    for(o = operands; o->name; o++)
+      if(!strncmp(text + 2, o->name, strlen(o->name)) && text[2 + strlen(o->name)] == ']') return o->value;
+    printf("FAIL: unknown operand %s\n", text);
+    exit(1);
+  }
+  value = strtol(text, &end, 0);
+  while(*end == ' ') end++;
+  if(!strncmp(end, "<<", 2)) value <<= strtol(end + 2, 0, 0);
+  return value;
+}
+
+void assemble(const char *program)
+{
+  char line[64], *args, *comma;
+  const char *next;
+  unsigned i, rept_start = 0, op;
+  long rept = -1;
+
+  code_size = 0;
+  for(; *program; program = next)
+  {
+    next = strstr(program, "\n\t");
+    if(!next) next = program + strlen(program);
+    snprintf(line, sizeof(line), "%.*s", (int)(next - program), program);
+    if(*next) next += 2;
+
+    args = strchr(line, ' ');
+    if(args) *args++ = 0;
+
+    if(!strcmp(line, ".rept")) { rept = operand(args); rept_start = code_size; continue; }
+    if(!strcmp(line, ".endr"))
+    {
+      // the block was assembled once, repeat it 'rept' times in all
+      unsigned size = code_size - rept_start;
+      if(rept == 0) code_size = rept_start;
+      for(; rept > 1; rept--, code_size += size) memcpy(&code[code_size], &code[rept_start], size * sizeof(code[0]));
+      rept = -1;
+      continue;
+    }
+
+    for(op = 0; mnemonics[op] && strcmp(mnemonics[op], line); op++);
+    if(!mnemonics[op]) { printf("FAIL: unknown instruction %s\n", line); exit(1); }
+    code[code_size].op = op;
+    code[code_size].a = code[code_size].b = 0;
+    if(args)
+    {
+      comma = strchr(args, ',');
+      if(comma) *comma = 0;
+      code[code_size].a = operand(args);
+      if(comma) code[code_size].b = operand(comma + 1);
+    }
+    code_size++;
+  }
+  for(i = 0; i < code_size; i++)
+    if(code[i].op != NOP && code[i].op != ORI && (code[i].b < 0 || code[i].b > 7))
+      { printf("FAIL: bad bit number\n"); exit(1); }
+}
+
+
+
+
+/*
+    Lines
+
+    The changes of SCLK and SDIO, with their times in ns. Time 0 is the start of the routine,
+    right after the previous SCLK falling edge.
+*/
+
+#define CHANGES 64
+
+struct line
+{
+  double time[CHANGES];
+  uint8_t level[CHANGES];
+  unsigned changes;
+};
+
+struct line sclk, sdio;
+
+void line_reset(struct line *line, uint8_t level)
+{
+  line->time[0] = -1e9;
+  line->level[0] = level;
+  line->changes = 1;
+}
+
+void line_set(struct line *line, double time, uint8_t level)
+{
+  if(line->level[line->changes - 1] == level) return;
+  line->time[line->changes] = time;
+  line->level[line->changes++] = level;
+}
+
+#define SDIO_UNDEFINED 2
+
+// level at 'time', -1 if it changes or is undefined from 'time' to 'time' + 'span'.
+int line_level(struct line *line, double time, double span)
+{
+  unsigned i;
+
+  for(i = line->changes - 1; line->time[i] > time + span; i--);
+  if(line->time[i] > time || line->level[i] == SDIO_UNDEFINED) return -1;
+  return line->level[i];
+}
+
+
+
+
+/*
+    Interpreter
+
+    Runs the code from cycle 0 with 'byte' in the register, the Si4735 driving SDIO with 'slave' when receiving.
+    Returns the register. 'cycles' is set to the cycles taken.
+*/
+
+uint8_t receiving, slave;
+unsigned cycles;
+
+// the Si4735's SDIO when receiving: undefined (SDIO_UNDEFINED) from each SCLK falling edge,
+// until the next bit is valid SI4735_SDIO_VALID_NS later. The start's edge brings bit 7.
+void slave_drive(void)
+{
+  unsigned i, bit = 8;
+
+  line_reset(&sdio, SDIO_UNDEFINED);
+  for(i = 1; i < sclk.changes; i++)
+    if(!sclk.level[i] && bit)
+    {
+      bit--;
+      line_set(&sdio, sclk.time[i], SDIO_UNDEFINED);
+      line_set(&sdio, sclk.time[i] + SI4735_SDIO_VALID_NS, (slave >> bit) & 1);
+    }
+}
+
+uint8_t pin_read(double time)
+{
+  int level;
+
+  // the slave's next changes depend only on the SCLK edges before 'time'
+  slave_drive();
+  level = line_level(&sdio, time - 1.5 * CYCLE_NS, CYCLE_NS);
+  host_check(level >= 0, "%s %02x: SDIO sampled while changing, at %.0f ns", receiving ? "receive" : "send", slave, time);
+  return level > 0;
+}
+
+void port_write(long address, long bit, uint8_t level, double time)
+{
+  if(address == io_address(&SI4735_SCLKPORT) && bit == si4735_bitnum(SI4735_SCLKBIT)) line_set(&sclk, time, level);
+  else if(address == io_address(&SI4735_SDIOPORT) && bit == si4735_bitnum(SI4735_SDIOBIT) && !receiving)
+    line_set(&sdio, time, level);
+  else { printf("FAIL: write to another line\n"); exit(1); }
+}
+
+uint8_t run(uint8_t byte)
+{
+  unsigned pc = 0, skip;
+  struct instruction *i;
+
+  cycles = 0;
+  line_reset(&sclk, 0);
+  line_set(&sclk, 0, 1);
+  line_set(&sclk, 0, 0);
+  if(!receiving) line_reset(&sdio, 0);
+
+  while(pc < code_size)
+  {
+    i = &code[pc++];
+    skip = 0;
+    switch(i->op)
+    {
+    case NOP: cycles += 1; break;
+    case SBI: case CBI: cycles += 2; port_write(i->a, i->b, i->op == SBI, cycles * CYCLE_NS); break;
+    case SBIC:
+      if(i->a != io_address(&SI4735_SDIOPIN) || i->b != si4735_bitnum(SI4735_SDIOBIT))
+        { printf("FAIL: read of another line\n"); exit(1); }
+      skip = !pin_read(cycles * CYCLE_NS);
+      cycles += 1;
+      break;
+    case SBRC: cycles += 1; skip = !((byte >> i->b) & 1); break;
+    case SBRS: cycles += 1; skip = (byte >> i->b) & 1; break;
+    case ORI: cycles += 1; byte |= i->b; break;
+    }
+    // all the instructions are one word
+    if(skip) { pc++; cycles += 1; }
+  }
+  return byte;
+}
+
+
+
+
+/*
+    Checks
+*/
+
+// SCLK high and low times, and the rising edges.
+double high_min, low_min, rise[8];
+
+void check_sclk(const char *routine, uint8_t byte)
+{
+  unsigned i, rises = 0;
+  double length;
+
+  // the start's pulse is the previous byte's last one
+  for(i = 3; i < sclk.changes; i++)
+  {
+    length = sclk.time[i] - sclk.time[i - 1];
+    if(sclk.level[i]) { if(length < low_min) low_min = length; rise[rises++ & 7] = sclk.time[i]; }
+    else if(length < high_min) high_min = length;
+  }
+  host_check(rises == 8 && !sclk.level[sclk.changes - 1], "%s %02x: %u SCLK pulses", routine, byte, rises);
+}
+
+void send(uint8_t byte)
+{
+  unsigned bit;
+  int level;
+
+  receiving = 0;
+  run(byte);
+  check_sclk("send", byte);
+  for(bit = 0; bit < 8; bit++)
+  {
+    level = line_level(&sdio, rise[bit] - SDIO_SETUP_NS, SDIO_SETUP_NS + SDIO_HOLD_NS);
+    host_check(level == ((byte >> (7 - bit)) & 1), "send %02x: bit %u sampled as %d", byte, 7 - bit, level);
+  }
+}
+
+void receive(uint8_t byte)
+{
+  uint8_t received;
+
+  receiving = 1;
+  slave = byte;
+  received = run(0);
+  check_sclk("receive", byte);
+  host_check(received == byte, "receive %02x: received %02x", byte, received);
+}
+
+
+
+
+int main(void)
+{
+  unsigned byte, send_cycles, receive_cycles;
+  char name[32];
+
+  set_operands();
+
+  high_min = low_min = 1e9;
+  assemble(send_program);
+  for(byte = 0; byte < 256; byte++) send(byte);
+  send_cycles = cycles;
+
+  assemble(receive_program);
+  for(byte = 0; byte < 256; byte++) receive(byte);
+  receive_cycles = cycles;
+
+  host_check(high_min >= SI4735_SCLK_HALF_NS, "SCLK high for %.0f ns", high_min);
+  host_check(low_min >= SI4735_SCLK_HALF_NS, "SCLK low for %.0f ns", low_min);
+
+  printf("%luMHz: send %u cycles per bit (%.0fkHz SCLK), receive %u cycles per bit (%.0fkHz SCLK), "
+    "sampling %u cycles after SCLK falls, SCLK high %.0f ns min, low %.0f ns min\n",
+    F_CPU / 1000000, send_cycles / 8, F_CPU / 1000.0 / (send_cycles / 8),
+    receive_cycles / 8, F_CPU / 1000.0 / (receive_cycles / 8), SI4735_SDIO_SETTLE, high_min, low_min);
+
+  snprintf(name, sizeof(name), "si4735_spi %luMHz", F_CPU / 1000000);
+  return host_result(name);
+}
@@ -0,0 +1,219 @@
+/*
+    Timer wheel against a reference model, and its tick cost against the number of timers.
+
+    TIMERS timers are started, restarted and cancelled at random while the ticks go by, a few at a time,
+    from just before the tick count wraps. Some timers restart themselves from their function.
+    Every timer must run once, at the very tick it expires at, and never once cancelled.
+
+    Then for 0 to 256 timers with random delays the lists walked per tick are measured:
+    the timers looked at per tick, which is the tick's cost on the MCU, must stay about 'timers / TIMER_SLOTS'.
+    The host time of timer_run() per tick and of a start and cancel pair are reported too.
+*/
+
+#define _GNU_SOURCE
+#include <time.h>
+#include "host.h"
+#include "../../src/timer.h"
+
+#define TIMERS 32
+#define STEPS 200000
+#define DELAY_MAX 3000
+#define TICKS_MAX 5
+#define PERIODIC 4
+#define PERIOD 37
+
+extern volatile uint16_t sched_ticks;
+extern uint16_t timer_now;
+extern struct timer *timer_wheel[TIMER_SLOTS];
+
+// xorshift
+uint32_t random_state = 2463534242UL;
+
+uint32_t random_next(void)
+{
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+
+
+
+/*
+    Reference model
+
+    'expected[i]' is the tick timer 'i' has to run at, while 'started[i]'.
+    The first PERIODIC timers restart themselves every PERIOD ticks from their function.
+*/
+
+struct timer timers[TIMERS];
+uint16_t expected[TIMERS];
+uint8_t started[TIMERS];
+unsigned long fired;
+
+void expire(unsigned i)
+{
+  host_check(started[i], "timer %u ran while not started", i);
+  host_check(timer_now == expected[i], "timer %u ran at %u, expected at %u", i, timer_now, expected[i]);
+  host_check(!timer_pending(&timers[i]), "timer %u still pending while running", i);
+  started[i] = 0;
+  fired++;
+  if(i < PERIODIC)
+  {
+    void (*run)(void) = timers[i].run;
+    timer_start(&timers[i], PERIOD, run);
+    expected[i] = sched_ticks + PERIOD;
+    started[i] = 1;
+  }
+}
+
+#define EXPIRE(n) void expire_##n(void) { expire(n); }
+
+EXPIRE(0) EXPIRE(1) EXPIRE(2) EXPIRE(3) EXPIRE(4) EXPIRE(5) EXPIRE(6) EXPIRE(7)
+EXPIRE(8) EXPIRE(9) EXPIRE(10) EXPIRE(11) EXPIRE(12) EXPIRE(13) EXPIRE(14) EXPIRE(15)
+EXPIRE(16) EXPIRE(17) EXPIRE(18) EXPIRE(19) EXPIRE(20) EXPIRE(21) EXPIRE(22) EXPIRE(23)
+EXPIRE(24) EXPIRE(25) EXPIRE(26) EXPIRE(27) EXPIRE(28) EXPIRE(29) EXPIRE(30) EXPIRE(31)
+
+void (* const expire_table[TIMERS])(void) = {
+  expire_0, expire_1, expire_2, expire_3, expire_4, expire_5, expire_6, expire_7,
+  expire_8, expire_9, expire_10, expire_11, expire_12, expire_13, expire_14, expire_15,
+  expire_16, expire_17, expire_18, expire_19, expire_20, expire_21, expire_22, expire_23,
+  expire_24, expire_25, expire_26, expire_27, expire_28, expire_29, expire_30, expire_31,
+};
+
+void model(void)
+{
+  unsigned long step;
+  unsigned i, ticks;
+  uint16_t delay;
+
+  sched_ticks = timer_now = 0x10000 - STEPS / 4;
+  for(step = 0; step < STEPS; step++)
+  {
+    i = random_next() % TIMERS;
+    switch(random_next() % 4)
+    {
+    case 0:
+      timer_cancel(&timers[i]);
+      started[i] = 0;
+      break;
+    case 1:
+    case 2:
+      delay = random_next() % (DELAY_MAX + 1);
+      timer_start(&timers[i], delay, expire_table[i]);
+      expected[i] = sched_ticks + (delay ? delay : 1);
+      started[i] = 1;
+      break;
+    default:
+      for(ticks = random_next() % (TICKS_MAX + 1); ticks; ticks--) sched_tick();
+      timer_run();
+      for(i = 0; i < TIMERS; i++)
+        host_check(!started[i] || (int16_t)(expected[i] - sched_ticks) > 0,
+          "timer %u not run at %u, now %u", i, expected[i], sched_ticks);
+      break;
+    }
+    for(i = 0; i < TIMERS; i++)
+      host_check(timer_pending(&timers[i]) == started[i], "timer %u pending %u", i, timer_pending(&timers[i]));
+    if(host_failures > 10) break;
+  }
+  printf("%lu timers run in %lu steps\n", fired, step);
+}
+
+
+
+
+/*
+    Tick cost
+*/
+
+#define BENCH_TIMERS 256
+#define BENCH_TICKS 20000
+#define BENCH_DELAY_MAX 2000
+
+struct timer bench_timers[BENCH_TIMERS];
+unsigned bench_active, bench_expired;
+
+void bench_expire(void)
+{
+  bench_expired++;
+}
+
+// restarts the expired timers, keeping the number of timers
+void bench_restart(void)
+{
+  struct timer *timer;
+
+  for(timer = bench_timers; bench_expired && timer < bench_timers + bench_active; timer++)
+    if(!timer_pending(timer))
+    {
+      timer_start(timer, 1 + random_next() % BENCH_DELAY_MAX, bench_expire);
+      bench_expired--;
+    }
+}
+
+double elapsed_ns(struct timespec *start)
+{
+  struct timespec end;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+}
+
+void bench(void)
+{
+  const unsigned counts[] = { 0, 8, 16, 32, 64, 128, 256 };
+  unsigned c, i, tick;
+  unsigned long walked, walked_max, n;
+  struct timespec start;
+  struct timer *timer;
+  double run_ns, start_ns;
+
+  for(i = 0; i < TIMERS; i++) timer_cancel(&timers[i]);
+
+  printf("%8s %14s %12s %12s %16s\n", "timers", "walked/tick", "walked max", "run ns/tick", "start+cancel ns");
+  for(c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+  {
+    for(i = 0; i < BENCH_TIMERS; i++) timer_cancel(&bench_timers[i]);
+    bench_active = bench_expired = counts[c];
+    bench_restart();
+
+    for(walked = walked_max = 0, run_ns = 0, tick = 0; tick < BENCH_TICKS; tick++)
+    {
+      // the timers the tick's walk looks at
+      for(n = 0, timer = timer_wheel[(timer_now + 1) & (TIMER_SLOTS - 1)]; timer; timer = timer->next) n++;
+      walked += n;
+      if(n > walked_max) walked_max = n;
+
+      sched_tick();
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      timer_run();
+      run_ns += elapsed_ns(&start);
+      bench_restart();
+    }
+    run_ns /= BENCH_TICKS;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(tick = 0; tick < BENCH_TICKS; tick++)
+    {
+      timer_start(&timers[0], 1 + tick % BENCH_DELAY_MAX, expire_0);
+      timer_cancel(&timers[0]);
+    }
+    start_ns = elapsed_ns(&start) / BENCH_TICKS;
+
+    printf("%8u %14.2f %12lu %12.1f %16.1f\n", bench_active, (double)walked / BENCH_TICKS, walked_max, run_ns, start_ns);
+    host_check((double)walked / BENCH_TICKS <= (double)bench_active / TIMER_SLOTS * 1.2 + 0.5,
+      "%u timers: %.2f walked per tick", bench_active, (double)walked / BENCH_TICKS);
+  }
+}
+
+
+
+
+int main(void)
+{
+  model();
+  bench();
+
+  return host_result("timer_wheel");
+}